@@ -0,0 +1,179 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "ackcodec_native.h"
+
+/* Bytes of a record: its type, then one triad for a single number or two for a range */
+#define SINGLE_SIZE 4
+#define RANGE_SIZE  7
+
+static int compare_sequence(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Writes the record for start..last at dst and returns its size
+ */
+static size_t write_record(unsigned char *dst, uint32_t start, uint32_t last)
+{
+	if (start == last) {
+		dst[0] = ACK_RECORD_SINGLE;
+		store_le24(dst + 1, start);
+		return SINGLE_SIZE;
+	}
+	dst[0] = ACK_RECORD_RANGE;
+	store_le24(dst + 1, start);
+	store_le24(dst + 4, last);
+	return RANGE_SIZE;
+}
+
+/**
+ * AckCodec::encode(): sorts the sequence numbers and writes them as a record
+ * count followed by single and range records of consecutive numbers, like
+ * RakLib's AcknowledgePacket payload. Duplicates are dropped.
+ */
+int ackcodec_native_encode(zval *return_value, zval *stream, zval *numbers)
+{
+	uint32_t n = zend_hash_num_elements(Z_ARRVAL_P(numbers)), count = 0, i, start, last, records = 0;
+	uint32_t *seq;
+	unsigned char *dst;
+	size_t size = 2;
+	zend_long v;
+	zval *value;
+	int sorted = 1;
+
+	if (n == 0) {
+		store_be16((unsigned char *) binarystream_write_ptr(stream, 2), 0);
+		return SUCCESS;
+	}
+	seq = safe_emalloc(n, sizeof(uint32_t), 0);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(numbers), value) {
+		v = zval_get_long(value);
+		if (v < 0 || v > ACK_MAX_SEQUENCE) {
+			efree(seq);
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Sequence number " ZEND_LONG_FMT " is out of range", v);
+			return FAILURE;
+		}
+		if (count > 0 && (uint32_t) v < seq[count - 1]) {
+			sorted = 0;
+		}
+		seq[count++] = (uint32_t) v;
+	} ZEND_HASH_FOREACH_END();
+	if (!sorted) {
+		qsort(seq, count, sizeof(uint32_t), compare_sequence);
+	}
+
+	/* sizes the records first so they are written in one go */
+	for (i = 1, start = last = seq[0]; i <= count; i++) {
+		if (i < count && seq[i] - last <= 1) {
+			last = seq[i];
+			continue;
+		}
+		size += start == last ? SINGLE_SIZE : RANGE_SIZE;
+		records++;
+		if (i < count) {
+			start = last = seq[i];
+		}
+	}
+	if (records > 0xffff) {
+		efree(seq);
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Too many records: %u", records);
+		return FAILURE;
+	}
+
+	dst = (unsigned char *) binarystream_write_ptr(stream, size);
+	store_be16(dst, (uint16_t) records);
+	dst += 2;
+	for (i = 1, start = last = seq[0]; i <= count; i++) {
+		if (i < count && seq[i] - last <= 1) {
+			last = seq[i];
+			continue;
+		}
+		dst += write_record(dst, start, last);
+		if (i < count) {
+			start = last = seq[i];
+		}
+	}
+	efree(seq);
+	return SUCCESS;
+}
+
+/**
+ * AckCodec::decode(): reads an ACK/NACK payload into a list of sequence
+ * numbers. Like RakLib, a range longer than max_range is cut short, decoding
+ * stops once max_count numbers were read and records missing at the end of
+ * the stream are ignored; a record cut in the middle throws.
+ */
+int ackcodec_native_decode(zval *return_value, zval *stream, zval *max_range_zv, zval *max_count_zv)
+{
+	zend_long max_range = zval_get_long(max_range_zv), max_count = zval_get_long(max_count_zv);
+	const unsigned char *ptr;
+	uint32_t records, i, start, end, n;
+	zend_long total = 0, offset;
+	size_t len;
+
+	if (max_range < 0 || max_count < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Limits must be positive"));
+		return FAILURE;
+	}
+	if ((ptr = (const unsigned char *) binarystream_read_ptr(stream, 2)) == NULL) {
+		return FAILURE;
+	}
+	records = host_be16(load_u16(ptr));
+	array_init_size(return_value, (uint32_t) MIN(records, (uint32_t) MIN(max_count, ACK_DEFAULT_MAX_COUNT)));
+
+	for (i = 0; i < records && total < max_count; i++) {
+		binarystream_cursor(stream, &len, &offset);
+		if (offset < 0 || (size_t) offset >= len) {
+			break;
+		}
+		if ((ptr = (const unsigned char *) binarystream_read_ptr(stream, 1)) == NULL) {
+			goto fail;
+		}
+		if (*ptr == ACK_RECORD_RANGE) {
+			if ((ptr = (const unsigned char *) binarystream_read_ptr(stream, 6)) == NULL) {
+				goto fail;
+			}
+			start = load_le24(ptr);
+			end = load_le24(ptr + 3);
+			if (end < start) {
+				continue;
+			}
+			if (end - start > (zend_ulong) max_range) {
+				end = start + (uint32_t) max_range;
+			}
+		} else {
+			if ((ptr = (const unsigned char *) binarystream_read_ptr(stream, 3)) == NULL) {
+				goto fail;
+			}
+			start = end = load_le24(ptr);
+		}
+		for (n = start; total < max_count; n++) {
+			add_next_index_long(return_value, (zend_long) n);
+			total++;
+			if (n == end) {
+				break;
+			}
+		}
+	}
+	return SUCCESS;
+
+fail:
+	zval_ptr_dtor(return_value);
+	ZVAL_NULL(return_value);
+	return FAILURE;
+}
@@ -0,0 +1,20 @@
+#ifndef ACKCODEC_NATIVE_H
+#define ACKCODEC_NATIVE_H
+
+#include <php.h>
+
+/* Record types of ACK/NACK payloads */
+#define ACK_RECORD_RANGE  0
+#define ACK_RECORD_SINGLE 1
+
+/* Largest RakNet sequence number, they are triads */
+#define ACK_MAX_SEQUENCE 0xffffff
+
+/* Limits applied by RakLib when decoding, the defaults of AckCodec::decode() */
+#define ACK_DEFAULT_MAX_RANGE 512
+#define ACK_DEFAULT_MAX_COUNT 4096
+
+int ackcodec_native_encode(zval *return_value, zval *stream, zval *numbers);
+int ackcodec_native_decode(zval *return_value, zval *stream, zval *max_range, zval *max_count);
+
+#endif
@@ -0,0 +1,873 @@
+#ifndef BINARY_NATIVE_H
+#define BINARY_NATIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+# include <stdlib.h>
+# define binary_bswap16(x) _byteswap_ushort(x)
+# define binary_bswap32(x) _byteswap_ulong(x)
+# define binary_bswap64(x) _byteswap_uint64(x)
+#elif defined(__GNUC__)
+# define binary_bswap16(x) __builtin_bswap16(x)
+# define binary_bswap32(x) __builtin_bswap32(x)
+# define binary_bswap64(x) __builtin_bswap64(x)
+#else
+# define binary_bswap16(x) ((uint16_t) (((x) >> 8) | ((x) << 8)))
+# define binary_bswap32(x) ((((x) & 0xff000000U) >> 24) | (((x) & 0x00ff0000U) >> 8) | (((x) & 0x0000ff00U) << 8) | (((x) & 0x000000ffU) << 24))
+# define binary_bswap64(x) (((uint64_t) binary_bswap32((uint32_t) (x)) << 32) | binary_bswap32((uint32_t) ((x) >> 32)))
+#endif
+
+#if defined(WORDS_BIGENDIAN) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+# define BINARY_BIG_ENDIAN_HOST 1
+# define BINARY_SWAP_BE 0
+# define BINARY_SWAP_LE 1
+#else
+# define BINARY_SWAP_BE 1
+# define BINARY_SWAP_LE 0
+#endif
+
+/* Vector instructions every build for the target can use, no runtime dispatch needed */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define BINARY_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define BINARY_SIMD_NEON 1
+#endif
+
+/* Number of values the bulk helpers below convert at a time */
+#define BINARY_BLOCK 64
+
+/* Result codes of the decoders below */
+#define BINARY_OK        0
+#define BINARY_EOF       1 /* the buffer ended in the middle of a value */
+#define BINARY_OVERLONG  2 /* a varint did not terminate within its maximum size */
+
+#define VARINT_MAX_BYTES   5
+#define VARLONG_MAX_BYTES 10
+
+/**
+ * Decodes an unsigned 32-bit varint at *pos, advancing *pos past it.
+ * *pos is left untouched when decoding fails.
+ */
+static inline int varint_read_u32(const unsigned char *buf, size_t len, size_t *pos, uint32_t *out)
+{
+	size_t p = *pos;
+	uint32_t value = 0;
+	unsigned char b;
+	int i;
+
+	if (p >= len) {
+		return BINARY_EOF;
+	}
+	if (len - p >= VARINT_MAX_BYTES) {
+		/* common case: the whole value is in bounds, no per-byte check */
+		for (i = 0; i < 7 * VARINT_MAX_BYTES; i += 7) {
+			b = buf[p++];
+			value |= (uint32_t) (b & 0x7f) << i;
+			if (!(b & 0x80)) {
+				*pos = p;
+				*out = value;
+				return BINARY_OK;
+			}
+		}
+		return BINARY_OVERLONG;
+	}
+	for (i = 0; i < 7 * VARINT_MAX_BYTES; i += 7) {
+		if (p >= len) {
+			return BINARY_EOF;
+		}
+		b = buf[p++];
+		value |= (uint32_t) (b & 0x7f) << i;
+		if (!(b & 0x80)) {
+			*pos = p;
+			*out = value;
+			return BINARY_OK;
+		}
+	}
+	return BINARY_OVERLONG;
+}
+
+/**
+ * Decodes an unsigned 64-bit varint at *pos, advancing *pos past it.
+ * *pos is left untouched when decoding fails.
+ */
+static inline int varint_read_u64(const unsigned char *buf, size_t len, size_t *pos, uint64_t *out)
+{
+	size_t p = *pos;
+	uint64_t value = 0;
+	unsigned char b;
+	int i;
+
+	if (p >= len) {
+		return BINARY_EOF;
+	}
+	if (len - p >= VARLONG_MAX_BYTES) {
+		for (i = 0; i < 7 * VARLONG_MAX_BYTES; i += 7) {
+			b = buf[p++];
+			value |= (uint64_t) (b & 0x7f) << i;
+			if (!(b & 0x80)) {
+				*pos = p;
+				*out = value;
+				return BINARY_OK;
+			}
+		}
+		return BINARY_OVERLONG;
+	}
+	for (i = 0; i < 7 * VARLONG_MAX_BYTES; i += 7) {
+		if (p >= len) {
+			return BINARY_EOF;
+		}
+		b = buf[p++];
+		value |= (uint64_t) (b & 0x7f) << i;
+		if (!(b & 0x80)) {
+			*pos = p;
+			*out = value;
+			return BINARY_OK;
+		}
+	}
+	return BINARY_OVERLONG;
+}
+
+/*
+ * Unaligned loads and stores of fixed-width integers in either byte order.
+ * memcpy() of a constant size compiles to a single move.
+ */
+static inline uint16_t load_u16(const unsigned char *p)
+{
+	uint16_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t load_u32(const unsigned char *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t load_u64(const unsigned char *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+#ifdef BINARY_BIG_ENDIAN_HOST
+# define load_be16(p) load_u16(p)
+# define load_be32(p) load_u32(p)
+# define load_be64(p) load_u64(p)
+# define load_le16(p) binary_bswap16(load_u16(p))
+# define load_le32(p) binary_bswap32(load_u32(p))
+# define load_le64(p) binary_bswap64(load_u64(p))
+# define host_be16(v) (v)
+# define host_be32(v) (v)
+# define host_be64(v) (v)
+# define host_le16(v) binary_bswap16(v)
+# define host_le32(v) binary_bswap32(v)
+# define host_le64(v) binary_bswap64(v)
+#else
+# define load_be16(p) binary_bswap16(load_u16(p))
+# define load_be32(p) binary_bswap32(load_u32(p))
+# define load_be64(p) binary_bswap64(load_u64(p))
+# define load_le16(p) load_u16(p)
+# define load_le32(p) load_u32(p)
+# define load_le64(p) load_u64(p)
+# define host_be16(v) binary_bswap16(v)
+# define host_be32(v) binary_bswap32(v)
+# define host_be64(v) binary_bswap64(v)
+# define host_le16(v) (v)
+# define host_le32(v) (v)
+# define host_le64(v) (v)
+#endif
+
+static inline void store_be16(unsigned char *p, uint16_t v)
+{
+	v = host_be16(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline void store_le16(unsigned char *p, uint16_t v)
+{
+	v = host_le16(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline void store_be32(unsigned char *p, uint32_t v)
+{
+	v = host_be32(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline void store_le32(unsigned char *p, uint32_t v)
+{
+	v = host_le32(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline void store_be64(unsigned char *p, uint64_t v)
+{
+	v = host_be64(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline void store_le64(unsigned char *p, uint64_t v)
+{
+	v = host_le64(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline uint32_t load_be24(const unsigned char *p)
+{
+	return ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+}
+
+static inline uint32_t load_le24(const unsigned char *p)
+{
+	return ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+}
+
+static inline void store_be24(unsigned char *p, uint32_t v)
+{
+	p[0] = (unsigned char) (v >> 16);
+	p[1] = (unsigned char) (v >> 8);
+	p[2] = (unsigned char) v;
+}
+
+static inline void store_le24(unsigned char *p, uint32_t v)
+{
+	p[0] = (unsigned char) v;
+	p[1] = (unsigned char) (v >> 8);
+	p[2] = (unsigned char) (v >> 16);
+}
+
+static inline float float_from_bits(uint32_t bits)
+{
+	float f;
+
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static inline uint32_t float_to_bits(float f)
+{
+	uint32_t bits;
+
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static inline double double_from_bits(uint64_t bits)
+{
+	double d;
+
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+static inline uint64_t double_to_bits(double d)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &d, sizeof(bits));
+	return bits;
+}
+
+/*
+ * Byte order reversal of n consecutive 16/32/64-bit values; src and dst may
+ * be the same but must not otherwise overlap
+ */
+static inline void binary_bswap16_block(unsigned char *dst, const unsigned char *src, size_t n)
+{
+	size_t i = 0;
+	uint16_t v;
+
+#if defined(BINARY_SIMD_SSE2)
+	for (; i + 8 <= n; i += 8) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (src + i * 2));
+
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *) (dst + i * 2), x);
+	}
+#elif defined(BINARY_SIMD_NEON)
+	for (; i + 8 <= n; i += 8) {
+		vst1q_u8(dst + i * 2, vrev16q_u8(vld1q_u8(src + i * 2)));
+	}
+#endif
+	for (; i < n; i++) {
+		v = binary_bswap16(load_u16(src + i * 2));
+		memcpy(dst + i * 2, &v, sizeof(v));
+	}
+}
+
+static inline void binary_bswap32_block(unsigned char *dst, const unsigned char *src, size_t n)
+{
+	size_t i = 0;
+	uint32_t v;
+
+#if defined(BINARY_SIMD_SSE2)
+	for (; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (src + i * 4));
+
+		x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *) (dst + i * 4), x);
+	}
+#elif defined(BINARY_SIMD_NEON)
+	for (; i + 4 <= n; i += 4) {
+		vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+	}
+#endif
+	for (; i < n; i++) {
+		v = binary_bswap32(load_u32(src + i * 4));
+		memcpy(dst + i * 4, &v, sizeof(v));
+	}
+}
+
+static inline void binary_bswap64_block(unsigned char *dst, const unsigned char *src, size_t n)
+{
+	size_t i = 0;
+	uint64_t v;
+
+#if defined(BINARY_SIMD_SSE2)
+	for (; i + 2 <= n; i += 2) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (src + i * 8));
+
+		x = _mm_shuffle_epi32(x, 0xb1);
+		x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *) (dst + i * 8), x);
+	}
+#elif defined(BINARY_SIMD_NEON)
+	for (; i + 2 <= n; i += 2) {
+		vst1q_u8(dst + i * 8, vrev64q_u8(vld1q_u8(src + i * 8)));
+	}
+#endif
+	for (; i < n; i++) {
+		v = binary_bswap64(load_u64(src + i * 8));
+		memcpy(dst + i * 8, &v, sizeof(v));
+	}
+}
+
+/**
+ * Fixed-width types of the Binary and BinaryStream accessors, named after
+ * their methods ("L" prefix is little-endian)
+ */
+typedef enum _binary_fixed_type {
+	BINARY_SHORT,
+	BINARY_SIGNED_SHORT,
+	BINARY_LSHORT,
+	BINARY_SIGNED_LSHORT,
+	BINARY_TRIAD,
+	BINARY_LTRIAD,
+	BINARY_INT,
+	BINARY_LINT,
+	BINARY_LONG,
+	BINARY_LLONG,
+	BINARY_FLOAT,
+	BINARY_LFLOAT,
+	BINARY_DOUBLE,
+	BINARY_LDOUBLE
+} binary_fixed_type;
+
+static inline size_t binary_fixed_size(int type)
+{
+	static const unsigned char sizes[] = {2, 2, 2, 2, 3, 3, 4, 4, 8, 8, 4, 4, 8, 8};
+
+	return sizes[type];
+}
+
+static inline int binary_fixed_is_float(int type)
+{
+	return type >= BINARY_FLOAT;
+}
+
+/**
+ * Decodes an integer type; the result is sign-extended for signed types
+ */
+static inline int64_t binary_fixed_load_int(const unsigned char *p, int type)
+{
+	switch (type) {
+		case BINARY_SHORT:         return load_be16(p);
+		case BINARY_SIGNED_SHORT:  return (int16_t) load_be16(p);
+		case BINARY_LSHORT:        return load_le16(p);
+		case BINARY_SIGNED_LSHORT: return (int16_t) load_le16(p);
+		case BINARY_TRIAD:         return load_be24(p);
+		case BINARY_LTRIAD:        return load_le24(p);
+		case BINARY_INT:           return (int32_t) load_be32(p);
+		case BINARY_LINT:          return (int32_t) load_le32(p);
+		case BINARY_LONG:          return (int64_t) load_be64(p);
+		default:                   return (int64_t) load_le64(p);
+	}
+}
+
+static inline double binary_fixed_load_float(const unsigned char *p, int type)
+{
+	switch (type) {
+		case BINARY_FLOAT:  return float_from_bits(load_be32(p));
+		case BINARY_LFLOAT: return float_from_bits(load_le32(p));
+		case BINARY_DOUBLE: return double_from_bits(load_be64(p));
+		default:            return double_from_bits(load_le64(p));
+	}
+}
+
+/**
+ * Encodes the low bits of v as an integer type
+ */
+static inline void binary_fixed_store_int(unsigned char *p, int64_t v, int type)
+{
+	switch (type) {
+		case BINARY_SHORT:
+		case BINARY_SIGNED_SHORT:  store_be16(p, (uint16_t) v); break;
+		case BINARY_LSHORT:
+		case BINARY_SIGNED_LSHORT: store_le16(p, (uint16_t) v); break;
+		case BINARY_TRIAD:         store_be24(p, (uint32_t) v); break;
+		case BINARY_LTRIAD:        store_le24(p, (uint32_t) v); break;
+		case BINARY_INT:           store_be32(p, (uint32_t) v); break;
+		case BINARY_LINT:          store_le32(p, (uint32_t) v); break;
+		case BINARY_LONG:          store_be64(p, (uint64_t) v); break;
+		default:                   store_le64(p, (uint64_t) v); break;
+	}
+}
+
+static inline void binary_fixed_store_float(unsigned char *p, double v, int type)
+{
+	switch (type) {
+		case BINARY_FLOAT:  store_be32(p, float_to_bits((float) v)); break;
+		case BINARY_LFLOAT: store_le32(p, float_to_bits((float) v)); break;
+		case BINARY_DOUBLE: store_be64(p, double_to_bits(v)); break;
+		default:            store_le64(p, double_to_bits(v)); break;
+	}
+}
+
+/**
+ * Decodes n <= BINARY_BLOCK values of an integer type, sign-extending the
+ * signed ones like binary_fixed_load_int()
+ */
+static inline void binary_fixed_load_int_block(int64_t *out, const unsigned char *src, size_t n, int type)
+{
+	union {
+		uint16_t u16[BINARY_BLOCK];
+		uint32_t u32[BINARY_BLOCK];
+	} tmp;
+	size_t i;
+
+	switch (type) {
+		case BINARY_SHORT:
+		case BINARY_SIGNED_SHORT:
+		case BINARY_LSHORT:
+		case BINARY_SIGNED_LSHORT:
+			if (type == BINARY_SHORT || type == BINARY_SIGNED_SHORT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap16_block((unsigned char *) tmp.u16, src, n);
+			} else {
+				memcpy(tmp.u16, src, n * sizeof(uint16_t));
+			}
+			if (type == BINARY_SIGNED_SHORT || type == BINARY_SIGNED_LSHORT) {
+				for (i = 0; i < n; i++) {
+					out[i] = (int16_t) tmp.u16[i];
+				}
+			} else {
+				for (i = 0; i < n; i++) {
+					out[i] = tmp.u16[i];
+				}
+			}
+			break;
+		case BINARY_INT:
+		case BINARY_LINT:
+			if (type == BINARY_INT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap32_block((unsigned char *) tmp.u32, src, n);
+			} else {
+				memcpy(tmp.u32, src, n * sizeof(uint32_t));
+			}
+			for (i = 0; i < n; i++) {
+				out[i] = (int32_t) tmp.u32[i];
+			}
+			break;
+		case BINARY_LONG:
+		case BINARY_LLONG:
+			if (type == BINARY_LONG ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap64_block((unsigned char *) out, src, n);
+			} else {
+				memcpy(out, src, n * sizeof(int64_t));
+			}
+			break;
+		default:
+			for (i = 0; i < n; i++) {
+				out[i] = binary_fixed_load_int(src + i * 3, type);
+			}
+			break;
+	}
+}
+
+/**
+ * Encodes the low bits of n <= BINARY_BLOCK values as an integer type
+ */
+static inline void binary_fixed_store_int_block(unsigned char *dst, const int64_t *in, size_t n, int type)
+{
+	union {
+		uint16_t u16[BINARY_BLOCK];
+		uint32_t u32[BINARY_BLOCK];
+	} tmp;
+	size_t i;
+
+	switch (type) {
+		case BINARY_SHORT:
+		case BINARY_SIGNED_SHORT:
+		case BINARY_LSHORT:
+		case BINARY_SIGNED_LSHORT:
+			for (i = 0; i < n; i++) {
+				tmp.u16[i] = (uint16_t) in[i];
+			}
+			if (type == BINARY_SHORT || type == BINARY_SIGNED_SHORT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap16_block(dst, (const unsigned char *) tmp.u16, n);
+			} else {
+				memcpy(dst, tmp.u16, n * sizeof(uint16_t));
+			}
+			break;
+		case BINARY_INT:
+		case BINARY_LINT:
+			for (i = 0; i < n; i++) {
+				tmp.u32[i] = (uint32_t) in[i];
+			}
+			if (type == BINARY_INT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap32_block(dst, (const unsigned char *) tmp.u32, n);
+			} else {
+				memcpy(dst, tmp.u32, n * sizeof(uint32_t));
+			}
+			break;
+		case BINARY_LONG:
+		case BINARY_LLONG:
+			if (type == BINARY_LONG ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap64_block(dst, (const unsigned char *) in, n);
+			} else {
+				memcpy(dst, in, n * sizeof(int64_t));
+			}
+			break;
+		default:
+			for (i = 0; i < n; i++) {
+				binary_fixed_store_int(dst + i * 3, in[i], type);
+			}
+			break;
+	}
+}
+
+/**
+ * Decodes n <= BINARY_BLOCK values of a float type
+ */
+static inline void binary_fixed_load_float_block(double *out, const unsigned char *src, size_t n, int type)
+{
+	float tmp[BINARY_BLOCK];
+	size_t i;
+
+	switch (type) {
+		case BINARY_FLOAT:
+		case BINARY_LFLOAT:
+			if (type == BINARY_FLOAT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap32_block((unsigned char *) tmp, src, n);
+			} else {
+				memcpy(tmp, src, n * sizeof(float));
+			}
+			for (i = 0; i < n; i++) {
+				out[i] = tmp[i];
+			}
+			break;
+		default:
+			if (type == BINARY_DOUBLE ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap64_block((unsigned char *) out, src, n);
+			} else {
+				memcpy(out, src, n * sizeof(double));
+			}
+			break;
+	}
+}
+
+/**
+ * Encodes n <= BINARY_BLOCK values of a float type
+ */
+static inline void binary_fixed_store_float_block(unsigned char *dst, const double *in, size_t n, int type)
+{
+	float tmp[BINARY_BLOCK];
+	size_t i;
+
+	switch (type) {
+		case BINARY_FLOAT:
+		case BINARY_LFLOAT:
+			for (i = 0; i < n; i++) {
+				tmp[i] = (float) in[i];
+			}
+			if (type == BINARY_FLOAT ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap32_block(dst, (const unsigned char *) tmp, n);
+			} else {
+				memcpy(dst, tmp, n * sizeof(float));
+			}
+			break;
+		default:
+			if (type == BINARY_DOUBLE ? BINARY_SWAP_BE : BINARY_SWAP_LE) {
+				binary_bswap64_block(dst, (const unsigned char *) in, n);
+			} else {
+				memcpy(dst, in, n * sizeof(double));
+			}
+			break;
+	}
+}
+
+/*
+ * binary_ctz32(x): index of the lowest set bit of x
+ * binary_bit_length64(x): index of the highest set bit of x plus one
+ * x must not be 0
+ */
+#if defined(_MSC_VER)
+# include <intrin.h>
+static inline unsigned binary_ctz32(uint32_t x)
+{
+	unsigned long i;
+
+	_BitScanForward(&i, x);
+	return (unsigned) i;
+}
+
+static inline unsigned binary_bit_length64(uint64_t x)
+{
+	unsigned long i;
+
+# if defined(_M_X64) || defined(_M_ARM64)
+	_BitScanReverse64(&i, x);
+	return (unsigned) i + 1;
+# else
+	if (x >> 32) {
+		_BitScanReverse(&i, (unsigned long) (x >> 32));
+		return (unsigned) i + 33;
+	}
+	_BitScanReverse(&i, (unsigned long) x);
+	return (unsigned) i + 1;
+# endif
+}
+#elif defined(__GNUC__)
+# define binary_ctz32(x) ((unsigned) __builtin_ctz(x))
+# define binary_bit_length64(x) (64 - (unsigned) __builtin_clzll(x))
+#else
+static inline unsigned binary_ctz32(uint32_t x)
+{
+	unsigned i = 0;
+
+	while (!(x & 1)) {
+		x >>= 1;
+		i++;
+	}
+	return i;
+}
+
+static inline unsigned binary_bit_length64(uint64_t x)
+{
+	unsigned i = 0;
+
+	while (x) {
+		x >>= 1;
+		i++;
+	}
+	return i;
+}
+#endif
+
+/*
+ * Bit i of the mask is the continuation bit of p[i], for VARINT_CHUNK bytes
+ */
+#if defined(BINARY_SIMD_SSE2)
+# define VARINT_CHUNK 16
+static inline uint32_t varint_chunk_mask(const unsigned char *p)
+{
+	return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) p));
+}
+#else
+# define VARINT_CHUNK 8
+static inline uint32_t varint_chunk_mask(const unsigned char *p)
+{
+	uint64_t x = load_le64(p) & 0x8080808080808080ULL;
+
+	return (uint32_t) ((x * 0x02040810204081ULL) >> 56);
+}
+#endif
+#define VARINT_CHUNK_BITS ((uint32_t) ((1UL << VARINT_CHUNK) - 1))
+
+/**
+ * Decodes count consecutive unsigned 32-bit varints at *pos into out.
+ *
+ * The terminating bytes of a whole chunk are found at once from its
+ * continuation bit mask, so there is no data-dependent branch per byte; a
+ * chunk of single-byte values is copied straight out. The last bytes of the
+ * buffer are decoded with varint_read_u32(). Fails like varint_read_u32(),
+ * with *pos at the start of the offending varint.
+ */
+static inline int varint_read_u32_array(const unsigned char *buf, size_t len, size_t *pos, uint32_t *out, size_t count)
+{
+	size_t p = *pos, n = 0, i, k;
+	unsigned start, end, shift;
+	uint32_t mask, ends, value;
+	int status;
+
+	while (n < count) {
+		if (p > len || len - p < VARINT_CHUNK) {
+			status = varint_read_u32(buf, len, &p, &value);
+			if (status != BINARY_OK) {
+				*pos = p;
+				return status;
+			}
+			out[n++] = value;
+			continue;
+		}
+
+		mask = varint_chunk_mask(buf + p);
+		if (mask == 0) {
+			k = count - n < VARINT_CHUNK ? count - n : VARINT_CHUNK;
+			for (i = 0; i < k; i++) {
+				out[n + i] = buf[p + i];
+			}
+			n += k;
+			p += k;
+			continue;
+		}
+
+		ends = ~mask & VARINT_CHUNK_BITS;
+		start = 0;
+		while (ends != 0 && n < count) {
+			end = binary_ctz32(ends);
+			if (end - start >= VARINT_MAX_BYTES) {
+				*pos = p + start;
+				return BINARY_OVERLONG;
+			}
+			value = 0;
+			for (shift = 0; start <= end; start++, shift += 7) {
+				value |= (uint32_t) (buf[p + start] & 0x7f) << shift;
+			}
+			out[n++] = value;
+			ends &= ends - 1;
+		}
+		if (start == 0) {
+			/* no value ends within the chunk */
+			*pos = p;
+			return BINARY_OVERLONG;
+		}
+		/* a value continuing past the chunk is decoded from the next one */
+		p += start;
+	}
+	*pos = p;
+	return BINARY_OK;
+}
+
+/**
+ * Number of bytes v takes as an unsigned varint
+ */
+static inline size_t varint_size_u64(uint64_t v)
+{
+	/* ceil(bits / 7) without a division by 7 or a loop, exact for 1 to 64 bits */
+	return (binary_bit_length64(v | 1) * 9 + 64) / 64;
+}
+
+static inline size_t varint_size_u32(uint32_t v)
+{
+	return varint_size_u64(v);
+}
+
+/**
+ * Encodes v as an unsigned varint at dst, which must have room for
+ * VARINT_MAX_BYTES, and returns the number of bytes written
+ */
+static inline size_t varint_write_u32(unsigned char *dst, uint32_t v)
+{
+	size_t n = 0;
+
+	while (v >= 0x80) {
+		dst[n++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	dst[n++] = (unsigned char) v;
+	return n;
+}
+
+/**
+ * Encodes v as an unsigned varint at dst, which must have room for
+ * VARLONG_MAX_BYTES, and returns the number of bytes written
+ */
+static inline size_t varint_write_u64(unsigned char *dst, uint64_t v)
+{
+	size_t n = 0;
+
+	while (v >= 0x80) {
+		dst[n++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	dst[n++] = (unsigned char) v;
+	return n;
+}
+
+static inline uint64_t zigzag_encode64(int64_t v)
+{
+	return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline uint32_t zigzag_encode32(int32_t v)
+{
+	return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+}
+
+static inline int32_t zigzag_decode32(uint32_t raw)
+{
+	return (int32_t) ((raw >> 1) ^ (0U - (raw & 1)));
+}
+
+static inline int64_t zigzag_decode64(uint64_t raw)
+{
+	return (int64_t) ((raw >> 1) ^ (0ULL - (raw & 1)));
+}
+
+/**
+ * Variable-length integer types of the BinaryStream accessors, named after
+ * their methods
+ */
+typedef enum _binary_varint_type {
+	BINARY_UNSIGNED_VARINT,
+	BINARY_VARINT,
+	BINARY_UNSIGNED_VARLONG,
+	BINARY_VARLONG
+} binary_varint_type;
+
+static inline int binary_varint_is_long(int type)
+{
+	return type >= BINARY_UNSIGNED_VARLONG;
+}
+
+/**
+ * Converts the raw bits of a decoded varint to the value returned for type
+ */
+static inline int64_t binary_varint_value(uint64_t raw, int type)
+{
+	switch (type) {
+		case BINARY_UNSIGNED_VARINT:  return (int64_t) (uint32_t) raw;
+		case BINARY_VARINT:           return zigzag_decode32((uint32_t) raw);
+		case BINARY_UNSIGNED_VARLONG: return (int64_t) raw;
+		default:                      return zigzag_decode64(raw);
+	}
+}
+
+/**
+ * Converts a value to the raw bits written for type, the inverse of
+ * binary_varint_value(); ints are truncated to 32 bits first
+ */
+static inline uint64_t binary_varint_raw(int64_t value, int type)
+{
+	switch (type) {
+		case BINARY_UNSIGNED_VARINT:  return (uint32_t) value;
+		case BINARY_VARINT:           return zigzag_encode32((int32_t) value);
+		case BINARY_UNSIGNED_VARLONG: return (uint64_t) value;
+		default:                      return zigzag_encode64(value);
+	}
+}
+
+#endif
@@ -0,0 +1,2473 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#ifndef PHP_WIN32
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "vector3_native.h"
+
+/* Slots of the declared BinaryStream properties, resolved once at MINIT */
+static uint32_t prop_buffer;
+static uint32_t prop_offset;
+
+static zend_object_handlers binarystream_handlers;
+
+/* Smallest allocation made for a written buffer */
+#define BINARYSTREAM_MIN_CAPACITY 64
+
+static zend_always_inline binarystream_object *binarystream_fetch(zend_object *obj)
+{
+	return (binarystream_object *) ((char *) obj - XtOffsetOf(binarystream_object, std));
+}
+
+static zend_always_inline zval *stream_buffer_slot(zend_object *obj)
+{
+	zval *zv = OBJ_PROP(obj, prop_buffer);
+
+	ZVAL_DEREF(zv);
+	return zv;
+}
+
+static zend_always_inline zend_long stream_offset(zend_object *obj)
+{
+	zval *zv = OBJ_PROP(obj, prop_offset);
+
+	ZVAL_DEREF(zv);
+	return Z_TYPE_P(zv) == IS_LONG ? Z_LVAL_P(zv) : zval_get_long(zv);
+}
+
+static zend_always_inline void stream_set_offset(zend_object *obj, zend_long offset)
+{
+	zval *zv = OBJ_PROP(obj, prop_offset);
+
+	ZVAL_DEREF(zv);
+	if (Z_TYPE_P(zv) != IS_LONG) {
+		zval_ptr_dtor(zv);
+	}
+	ZVAL_LONG(zv, offset);
+}
+
+static void stream_flatten(binarystream_object *intern);
+
+/**
+ * Returns the readable bytes of the stream: its window when it is a view,
+ * the buffer property otherwise, after flattening the segments in front of it
+ */
+static zend_always_inline const char *stream_bytes(zend_object *obj, size_t *len)
+{
+	binarystream_object *intern = binarystream_fetch(obj);
+	zval *zv;
+
+	if (UNEXPECTED(intern->view != NULL)) {
+		*len = intern->view_len;
+		return intern->view;
+	}
+	if (UNEXPECTED(intern->segment_count != 0)) {
+		stream_flatten(intern);
+	}
+	zv = stream_buffer_slot(obj);
+	if (EXPECTED(Z_TYPE_P(zv) == IS_STRING)) {
+		*len = Z_STRLEN_P(zv);
+		return Z_STRVAL_P(zv);
+	}
+	*len = 0;
+	return "";
+}
+
+/*
+ * The owner of a view is the string its bytes live in, or the resource of the
+ * file they are mapped from
+ */
+static zend_always_inline void owner_addref(zend_refcounted *owner)
+{
+	if (GC_TYPE(owner) == IS_STRING) {
+		zend_string_addref((zend_string *) owner);
+	} else {
+		GC_ADDREF(owner);
+	}
+}
+
+static zend_always_inline void owner_release(zend_refcounted *owner)
+{
+	if (GC_TYPE(owner) == IS_STRING) {
+		zend_string_release((zend_string *) owner);
+	} else {
+		/* the last reference closes the file stream, which unmaps it */
+		zend_list_delete((zend_resource *) owner);
+	}
+}
+
+static void stream_drop_view(binarystream_object *intern)
+{
+	owner_release(intern->view_owner);
+	intern->view_owner = NULL;
+	intern->view = NULL;
+	intern->view_len = 0;
+}
+
+/**
+ * Points the stream at len bytes of owner starting at data, without copying
+ */
+static void stream_set_view(binarystream_object *intern, zend_refcounted *owner, const char *data, size_t len)
+{
+	zval *zv = stream_buffer_slot(&intern->std);
+
+	owner_addref(owner);
+	if (intern->view) {
+		stream_drop_view(intern);
+	}
+	intern->view_owner = owner;
+	intern->view = data;
+	intern->view_len = len;
+
+	/* the property holds a placeholder until the window is materialized */
+	zval_ptr_dtor(zv);
+	ZVAL_EMPTY_STRING(zv);
+}
+
+static size_t grow_capacity(size_t capacity, size_t needed)
+{
+	if (capacity < BINARYSTREAM_MIN_CAPACITY) {
+		capacity = BINARYSTREAM_MIN_CAPACITY;
+	}
+	while (capacity < needed) {
+		if (capacity > SIZE_MAX / 2) {
+			return needed;
+		}
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/**
+ * Copies the window of a view into an owned buffer string with room for
+ * extra more bytes and stores it in the buffer property
+ */
+static void stream_materialize(binarystream_object *intern, size_t extra)
+{
+	zval *zv = stream_buffer_slot(&intern->std);
+	size_t len = intern->view_len;
+	size_t capacity = grow_capacity(intern->capacity, len + extra);
+	zend_string *copy = zend_string_alloc(capacity, 0);
+
+	memcpy(ZSTR_VAL(copy), intern->view, len);
+	ZSTR_LEN(copy) = len;
+	ZSTR_VAL(copy)[len] = '\0';
+	stream_drop_view(intern);
+
+	GC_ADDREF(copy);
+	zval_ptr_dtor(zv);
+	ZVAL_NEW_STR(zv, copy);
+	if (intern->owned) {
+		zend_string_release(intern->owned);
+	}
+	intern->owned = copy;
+	intern->capacity = capacity;
+}
+
+/*
+ * Segmented streams: put() of a string of at least segment_threshold bytes
+ * adds a reference to it instead of copying it. What was written before it is
+ * detached from the buffer property as a segment of its own, so the property
+ * only ever holds the bytes written after the last segment.
+ */
+
+static void stream_push_segment(binarystream_object *intern, zend_refcounted *owner, const char *ptr, size_t len)
+{
+	binarystream_segment *segment;
+
+	if (UNEXPECTED(len > SIZE_MAX - intern->segments_len)) {
+		zend_error_noreturn(E_ERROR, "Possible integer overflow in memory allocation (%zu + %zu)", intern->segments_len, len);
+	}
+	if (intern->segment_count == intern->segment_slots) {
+		intern->segment_slots = intern->segment_slots ? intern->segment_slots * 2 : 8;
+		intern->segments = safe_erealloc(intern->segments, intern->segment_slots, sizeof(binarystream_segment), 0);
+	}
+	owner_addref(owner);
+	segment = &intern->segments[intern->segment_count++];
+	segment->owner = owner;
+	segment->ptr = ptr;
+	segment->len = len;
+	intern->segments_len += len;
+}
+
+static void stream_drop_segments(binarystream_object *intern)
+{
+	uint32_t i;
+
+	for (i = 0; i < intern->segment_count; i++) {
+		owner_release(intern->segments[i].owner);
+	}
+	intern->segment_count = 0;
+	intern->segments_len = 0;
+}
+
+/**
+ * Appends len bytes of owner at ptr as a segment, after turning the bytes
+ * written so far into one
+ */
+static void stream_add_segment(binarystream_object *intern, zend_refcounted *owner, const char *ptr, size_t len)
+{
+	zval *zv = stream_buffer_slot(&intern->std);
+	zend_string *buf;
+	int spare;
+
+	if (intern->view) {
+		if (intern->view_len) {
+			stream_push_segment(intern, intern->view_owner, intern->view, intern->view_len);
+		}
+		stream_drop_view(intern);
+	} else if (Z_TYPE_P(zv) == IS_STRING && Z_STRLEN_P(zv)) {
+		buf = zend_string_copy(Z_STR_P(zv));
+		spare = buf == intern->owned && intern->capacity / 2 > ZSTR_LEN(buf);
+		zval_ptr_dtor(zv);
+		ZVAL_EMPTY_STRING(zv);
+		if (intern->owned) {
+			zend_string_release(intern->owned);
+			intern->owned = NULL;
+		}
+		if (spare && GC_REFCOUNT(buf) == 1) {
+			/* nothing is written into it anymore, give back the unused capacity */
+			buf = zend_string_truncate(buf, ZSTR_LEN(buf), 0);
+		}
+		stream_push_segment(intern, (zend_refcounted *) buf, ZSTR_VAL(buf), ZSTR_LEN(buf));
+		zend_string_release(buf);
+		/* the buffer behind the segment starts small again */
+		intern->capacity = 0;
+	}
+	stream_push_segment(intern, owner, ptr, len);
+}
+
+/**
+ * Copies the segments and the buffer behind them into one owned buffer string
+ * of exactly the size needed, unless the capacity kept by the stream is larger
+ */
+static void stream_flatten(binarystream_object *intern)
+{
+	zval *zv = stream_buffer_slot(&intern->std);
+	size_t tail = Z_TYPE_P(zv) == IS_STRING ? Z_STRLEN_P(zv) : 0;
+	size_t len, capacity;
+	zend_string *flat;
+	char *dst;
+	uint32_t i;
+
+	if (UNEXPECTED(tail > SIZE_MAX - intern->segments_len - _ZSTR_STRUCT_SIZE(0))) {
+		zend_error_noreturn(E_ERROR, "Possible integer overflow in memory allocation (%zu + %zu)", intern->segments_len, tail);
+	}
+	len = intern->segments_len + tail;
+	capacity = intern->capacity > len ? intern->capacity : len;
+	flat = zend_string_alloc(capacity, 0);
+	dst = ZSTR_VAL(flat);
+	for (i = 0; i < intern->segment_count; i++) {
+		memcpy(dst, intern->segments[i].ptr, intern->segments[i].len);
+		dst += intern->segments[i].len;
+	}
+	if (tail) {
+		memcpy(dst, Z_STRVAL_P(zv), tail);
+	}
+	ZSTR_LEN(flat) = len;
+	ZSTR_VAL(flat)[len] = '\0';
+	stream_drop_segments(intern);
+
+	GC_ADDREF(flat);
+	zval_ptr_dtor(zv);
+	ZVAL_NEW_STR(zv, flat);
+	if (intern->owned) {
+		zend_string_release(intern->owned);
+	}
+	intern->owned = flat;
+	intern->capacity = capacity;
+}
+
+/**
+ * Makes the buffer property hold every byte of the stream before PHP code
+ * gets to see it
+ */
+static void stream_expose(binarystream_object *intern)
+{
+	if (intern->view) {
+		stream_materialize(intern, 0);
+	} else if (intern->segment_count) {
+		stream_flatten(intern);
+	}
+}
+
+static zend_object *binarystream_create_object(zend_class_entry *ce)
+{
+	binarystream_object *intern = zend_object_alloc(sizeof(binarystream_object), ce);
+
+	memset(intern, 0, XtOffsetOf(binarystream_object, std));
+	intern->partial_offset = -1;
+	zend_object_std_init(&intern->std, ce);
+	object_properties_init(&intern->std, ce);
+	intern->std.handlers = &binarystream_handlers;
+
+	return &intern->std;
+}
+
+static void binarystream_free_object(zend_object *obj)
+{
+	binarystream_object *intern = binarystream_fetch(obj);
+
+	if (intern->owned) {
+		zend_string_release(intern->owned);
+	}
+	if (intern->view) {
+		stream_drop_view(intern);
+	}
+	if (intern->segments) {
+		stream_drop_segments(intern);
+		efree(intern->segments);
+	}
+	zend_object_std_dtor(obj);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zend_object *binarystream_clone_object(zend_object *old_obj)
+{
+#else
+static zend_object *binarystream_clone_object(zval *object)
+{
+	zend_object *old_obj = Z_OBJ_P(object);
+#endif
+	zend_object *new_obj = binarystream_create_object(old_obj->ce);
+	binarystream_object *old_intern = binarystream_fetch(old_obj);
+	binarystream_object *new_intern = binarystream_fetch(new_obj);
+	uint32_t i;
+
+	/* the clone shares the buffer string or window; whichever stream writes first copies it */
+	zend_objects_clone_members(new_obj, old_obj);
+	new_intern->capacity = old_intern->capacity;
+	if (old_intern->view) {
+		owner_addref(old_intern->view_owner);
+		new_intern->view_owner = old_intern->view_owner;
+		new_intern->view = old_intern->view;
+		new_intern->view_len = old_intern->view_len;
+	}
+	new_intern->segment_threshold = old_intern->segment_threshold;
+	for (i = 0; i < old_intern->segment_count; i++) {
+		stream_push_segment(new_intern, old_intern->segments[i].owner, old_intern->segments[i].ptr, old_intern->segments[i].len);
+	}
+
+	return new_obj;
+}
+
+/*
+ * While a stream is a view the buffer property only holds a placeholder, so
+ * every property access path that can observe it materializes the window
+ * first. The runtime cache slot is never handed to the standard handlers for
+ * the buffer property, otherwise the engine would read the slot directly.
+ */
+#if PHP_VERSION_ID >= 80000
+# define BUFFER_MEMBER(member) zend_string_equals_literal(member, "buffer")
+# define HANDLER_OBJ(object) (object)
+#else
+# define BUFFER_MEMBER(member) (Z_TYPE_P(member) == IS_STRING && zend_string_equals_literal(Z_STR_P(member), "buffer"))
+# define HANDLER_OBJ(object) Z_OBJ_P(object)
+#endif
+
+#if PHP_VERSION_ID >= 80000
+static zval *binarystream_read_property(zend_object *object, zend_string *member, int type, void **cache_slot, zval *rv)
+#else
+static zval *binarystream_read_property(zval *object, zval *member, int type, void **cache_slot, zval *rv)
+#endif
+{
+	if (BUFFER_MEMBER(member)) {
+		binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+		stream_expose(intern);
+		cache_slot = NULL;
+	}
+	return zend_std_read_property(object, member, type, cache_slot, rv);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zval *binarystream_write_property(zend_object *object, zend_string *member, zval *value, void **cache_slot)
+#else
+static zval *binarystream_write_property(zval *object, zval *member, zval *value, void **cache_slot)
+#endif
+{
+	if (BUFFER_MEMBER(member)) {
+		binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+		if (intern->view) {
+			stream_drop_view(intern);
+		}
+		stream_drop_segments(intern);
+		intern->partial_offset = -1;
+		intern->error = BINARY_OK;
+		cache_slot = NULL;
+	}
+	return zend_std_write_property(object, member, value, cache_slot);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zval *binarystream_get_property_ptr_ptr(zend_object *object, zend_string *member, int type, void **cache_slot)
+#else
+static zval *binarystream_get_property_ptr_ptr(zval *object, zval *member, int type, void **cache_slot)
+#endif
+{
+	if (BUFFER_MEMBER(member)) {
+		binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+		stream_expose(intern);
+		/* the buffer may be modified through the returned pointer */
+		intern->partial_offset = -1;
+		cache_slot = NULL;
+	}
+	return zend_std_get_property_ptr_ptr(object, member, type, cache_slot);
+}
+
+#if PHP_VERSION_ID >= 80000
+static int binarystream_has_property(zend_object *object, zend_string *member, int has_set_exists, void **cache_slot)
+#else
+static int binarystream_has_property(zval *object, zval *member, int has_set_exists, void **cache_slot)
+#endif
+{
+	if (BUFFER_MEMBER(member)) {
+		binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+		stream_expose(intern);
+		cache_slot = NULL;
+	}
+	return zend_std_has_property(object, member, has_set_exists, cache_slot);
+}
+
+#if PHP_VERSION_ID >= 80000
+static void binarystream_unset_property(zend_object *object, zend_string *member, void **cache_slot)
+#else
+static void binarystream_unset_property(zval *object, zval *member, void **cache_slot)
+#endif
+{
+	if (BUFFER_MEMBER(member)) {
+		binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+		if (intern->view) {
+			stream_drop_view(intern);
+		}
+		stream_drop_segments(intern);
+		intern->partial_offset = -1;
+		cache_slot = NULL;
+	}
+	zend_std_unset_property(object, member, cache_slot);
+}
+
+#if PHP_VERSION_ID >= 80000
+static HashTable *binarystream_get_properties(zend_object *object)
+#else
+static HashTable *binarystream_get_properties(zval *object)
+#endif
+{
+	binarystream_object *intern = binarystream_fetch(HANDLER_OBJ(object));
+
+	stream_expose(intern);
+	return zend_std_get_properties(object);
+}
+
+void binarystream_module_init(void)
+{
+	zend_property_info *info;
+
+	info = zend_hash_str_find_ptr(&pocketmine_utils_binarystream_ce->properties_info, ZEND_STRL("buffer"));
+	prop_buffer = info->offset;
+	info = zend_hash_str_find_ptr(&pocketmine_utils_binarystream_ce->properties_info, ZEND_STRL("offset"));
+	prop_offset = info->offset;
+
+	pocketmine_utils_binarystream_ce->create_object = binarystream_create_object;
+	memcpy(&binarystream_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	binarystream_handlers.offset = XtOffsetOf(binarystream_object, std);
+	binarystream_handlers.free_obj = binarystream_free_object;
+	binarystream_handlers.clone_obj = binarystream_clone_object;
+	binarystream_handlers.read_property = binarystream_read_property;
+	binarystream_handlers.write_property = binarystream_write_property;
+	binarystream_handlers.get_property_ptr_ptr = binarystream_get_property_ptr_ptr;
+	binarystream_handlers.has_property = binarystream_has_property;
+	binarystream_handlers.unset_property = binarystream_unset_property;
+	binarystream_handlers.get_properties = binarystream_get_properties;
+}
+
+/**
+ * Makes sure len more bytes fit behind the end of the buffer and returns the
+ * buffer string, which is then only referenced by the property and `owned`.
+ *
+ * The buffer string is allocated with spare capacity (like smart_str) and kept
+ * in the buffer property itself, so reading it needs no extra work. A string
+ * that was assigned from outside or is shared with a getBuffer() result is
+ * copied into a fresh allocation first, and so is the window of a view.
+ */
+static zend_string *stream_reserve(binarystream_object *intern, size_t len)
+{
+	zval *zv;
+	zend_string *buf, *copy;
+	size_t used, needed, capacity;
+
+	if (UNEXPECTED(intern->view != NULL)) {
+		if (UNEXPECTED(len > SIZE_MAX - intern->view_len - _ZSTR_STRUCT_SIZE(0))) {
+			zend_error_noreturn(E_ERROR, "Possible integer overflow in memory allocation (%zu + %zu)", intern->view_len, len);
+		}
+		stream_materialize(intern, len);
+		return intern->owned;
+	}
+
+	zv = stream_buffer_slot(&intern->std);
+	buf = Z_TYPE_P(zv) == IS_STRING ? Z_STR_P(zv) : NULL;
+	used = buf ? ZSTR_LEN(buf) : 0;
+	if (UNEXPECTED(len > SIZE_MAX - used - _ZSTR_STRUCT_SIZE(0))) {
+		zend_error_noreturn(E_ERROR, "Possible integer overflow in memory allocation (%zu + %zu)", used, len);
+	}
+	needed = used + len;
+
+	if (EXPECTED(buf != NULL && buf == intern->owned && GC_REFCOUNT(buf) == 2)) {
+		if (EXPECTED(needed <= intern->capacity)) {
+			return buf;
+		}
+		capacity = grow_capacity(intern->capacity, needed);
+		buf = (zend_string *) erealloc(buf, ZEND_MM_ALIGNED_SIZE(_ZSTR_STRUCT_SIZE(capacity)));
+		ZVAL_NEW_STR(zv, buf);
+		intern->owned = buf;
+		intern->capacity = capacity;
+		return buf;
+	}
+
+	capacity = grow_capacity(intern->capacity, needed);
+	copy = zend_string_alloc(capacity, 0);
+	if (used) {
+		memcpy(ZSTR_VAL(copy), ZSTR_VAL(buf), used);
+	}
+	ZSTR_LEN(copy) = used;
+	ZSTR_VAL(copy)[used] = '\0';
+	GC_ADDREF(copy);
+
+	zval_ptr_dtor(zv);
+	ZVAL_NEW_STR(zv, copy);
+	if (intern->owned) {
+		zend_string_release(intern->owned);
+	}
+	intern->owned = copy;
+	intern->capacity = capacity;
+	return copy;
+}
+
+/**
+ * Appends len bytes to the end of the buffer and returns where to write them
+ */
+static zend_always_inline char *stream_append(zend_object *obj, size_t len)
+{
+	binarystream_object *intern = binarystream_fetch(obj);
+	zend_string *buf = stream_reserve(intern, len);
+	char *ptr = ZSTR_VAL(buf) + ZSTR_LEN(buf);
+
+	ZSTR_LEN(buf) += len;
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+
+	return ptr;
+}
+
+char *binarystream_write_ptr(zval *stream, size_t len)
+{
+	return stream_append(Z_OBJ_P(stream), len);
+}
+
+size_t binarystream_length(zval *stream)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zval *zv;
+
+	if (intern->view) {
+		return intern->view_len;
+	}
+	zv = stream_buffer_slot(&intern->std);
+	return intern->segments_len + (Z_TYPE_P(zv) == IS_STRING ? Z_STRLEN_P(zv) : 0);
+}
+
+void binarystream_truncate(zval *stream, size_t len)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zend_string *buf;
+
+	if (binarystream_length(stream) <= len) {
+		return;
+	}
+	if (len < intern->segments_len) {
+		stream_flatten(intern);
+	}
+	/* copies a view or shared buffer so only this stream sees the change */
+	buf = stream_reserve(intern, 0);
+	ZSTR_LEN(buf) = len - intern->segments_len;
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+	if (stream_offset(&intern->std) > (zend_long) len) {
+		stream_set_offset(&intern->std, (zend_long) len);
+	}
+}
+
+void binarystream_init_owned(zval *return_value, zend_string *buf, size_t capacity)
+{
+	binarystream_object *intern;
+	zval *zv;
+
+	object_init_ex(return_value, pocketmine_utils_binarystream_ce);
+	intern = binarystream_fetch(Z_OBJ_P(return_value));
+	zv = stream_buffer_slot(&intern->std);
+	zval_ptr_dtor(zv);
+	ZVAL_NEW_STR(zv, buf);
+	GC_ADDREF(buf);
+	intern->owned = buf;
+	intern->capacity = capacity;
+	stream_set_offset(&intern->std, 0);
+}
+
+void binarystream_init_empty(zval *return_value, size_t capacity)
+{
+	zend_string *buf;
+
+	if (capacity < BINARYSTREAM_MIN_CAPACITY) {
+		capacity = BINARYSTREAM_MIN_CAPACITY;
+	}
+	buf = zend_string_alloc(capacity, 0);
+	ZSTR_LEN(buf) = 0;
+	ZSTR_VAL(buf)[0] = '\0';
+	binarystream_init_owned(return_value, buf, capacity);
+}
+
+const char *binarystream_bytes_of(zval *value, size_t *len)
+{
+	ZVAL_DEREF(value);
+	if (Z_TYPE_P(value) == IS_STRING) {
+		*len = Z_STRLEN_P(value);
+		return Z_STRVAL_P(value);
+	}
+	if (Z_TYPE_P(value) == IS_OBJECT && instanceof_function(Z_OBJCE_P(value), pocketmine_utils_binarystream_ce)) {
+		return stream_bytes(Z_OBJ_P(value), len);
+	}
+	return NULL;
+}
+
+const char *binarystream_piece(zval *value, size_t i, size_t *len)
+{
+	binarystream_object *intern;
+	zval *zv;
+
+	ZVAL_DEREF(value);
+	if (Z_TYPE_P(value) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(value), pocketmine_utils_binarystream_ce)) {
+		return i == 0 ? binarystream_bytes_of(value, len) : NULL;
+	}
+	intern = binarystream_fetch(Z_OBJ_P(value));
+	if (i < intern->segment_count) {
+		*len = intern->segments[i].len;
+		return intern->segments[i].ptr;
+	}
+	if (i > intern->segment_count) {
+		return NULL;
+	}
+	if (intern->view) {
+		*len = intern->view_len;
+		return intern->view;
+	}
+	zv = stream_buffer_slot(Z_OBJ_P(value));
+	if (Z_TYPE_P(zv) == IS_STRING) {
+		*len = Z_STRLEN_P(zv);
+		return Z_STRVAL_P(zv);
+	}
+	*len = 0;
+	return "";
+}
+
+void binarystream_write_varint(zval *stream, uint64_t raw)
+{
+	zend_string *buf = stream_reserve(binarystream_fetch(Z_OBJ_P(stream)), VARLONG_MAX_BYTES);
+
+	ZSTR_LEN(buf) += varint_write_u64((unsigned char *) ZSTR_VAL(buf) + ZSTR_LEN(buf), raw);
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+}
+
+int binarystream_put(zval *return_value, zval *stream, zval *str)
+{
+	binarystream_object *intern;
+	zend_string *tmp;
+	const char *val;
+	size_t len;
+
+	if (EXPECTED(Z_TYPE_P(str) == IS_STRING)) {
+		val = Z_STRVAL_P(str);
+		len = Z_STRLEN_P(str);
+		intern = binarystream_fetch(Z_OBJ_P(stream));
+		if (UNEXPECTED(intern->segment_threshold != 0 && len >= intern->segment_threshold)) {
+			stream_add_segment(intern, (zend_refcounted *) Z_STR_P(str), val, len);
+		} else if (len) {
+			memcpy(stream_append(Z_OBJ_P(stream), len), val, len);
+		}
+		return SUCCESS;
+	}
+	tmp = zval_get_string(str);
+	if (ZSTR_LEN(tmp)) {
+		memcpy(stream_append(Z_OBJ_P(stream), ZSTR_LEN(tmp)), ZSTR_VAL(tmp), ZSTR_LEN(tmp));
+	}
+	zend_string_release(tmp);
+	return SUCCESS;
+}
+
+int binarystream_put_byte(zval *return_value, zval *stream, zval *value)
+{
+	*stream_append(Z_OBJ_P(stream), 1) = (char) zval_get_long(value);
+	return SUCCESS;
+}
+
+int binarystream_reserve(zval *return_value, zval *stream, zval *len)
+{
+	zend_long n = zval_get_long(len);
+
+	if (n < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Length must be positive"));
+		return FAILURE;
+	}
+	stream_reserve(binarystream_fetch(Z_OBJ_P(stream)), (size_t) n);
+	return SUCCESS;
+}
+
+/**
+ * Empties the stream; an unshared buffer is truncated in place so its
+ * capacity is reused by the next packet written into this stream
+ */
+int binarystream_reset(zval *return_value, zval *stream)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zval *zv = stream_buffer_slot(&intern->std);
+
+	if (intern->view) {
+		stream_drop_view(intern);
+	}
+	stream_drop_segments(intern);
+	intern->partial_offset = -1;
+	intern->error = BINARY_OK;
+	if (Z_TYPE_P(zv) == IS_STRING && Z_STR_P(zv) == intern->owned && GC_REFCOUNT(intern->owned) == 2) {
+		ZSTR_LEN(intern->owned) = 0;
+		ZSTR_VAL(intern->owned)[0] = '\0';
+		zend_string_forget_hash_val(intern->owned);
+	} else {
+		zval_ptr_dtor(zv);
+		ZVAL_EMPTY_STRING(zv);
+		if (intern->owned) {
+			zend_string_release(intern->owned);
+			intern->owned = NULL;
+		}
+	}
+	stream_set_offset(&intern->std, 0);
+	return SUCCESS;
+}
+
+int binarystream_set_segment_threshold(zval *return_value, zval *stream, zval *threshold)
+{
+	zend_long n = zval_get_long(threshold);
+
+	if (n < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Threshold must be positive"));
+		return FAILURE;
+	}
+	binarystream_fetch(Z_OBJ_P(stream))->segment_threshold = (size_t) n;
+	return SUCCESS;
+}
+
+int binarystream_segment_count(zval *return_value, zval *stream)
+{
+	ZVAL_LONG(return_value, (zend_long) binarystream_fetch(Z_OBJ_P(stream))->segment_count);
+	return SUCCESS;
+}
+
+size_t binarystream_recycle(zval *stream, size_t max_capacity)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zval *zv;
+
+	binarystream_reset(NULL, stream);
+	intern->segment_threshold = 0;
+	if (intern->capacity > max_capacity) {
+		if (intern->owned) {
+			zv = stream_buffer_slot(&intern->std);
+			zval_ptr_dtor(zv);
+			ZVAL_EMPTY_STRING(zv);
+			zend_string_release(intern->owned);
+			intern->owned = NULL;
+		}
+		intern->capacity = 0;
+	}
+	return binarystream_retained(stream);
+}
+
+size_t binarystream_retained(zval *stream)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+
+	return intern->owned ? intern->capacity : 0;
+}
+
+/**
+ * Consumes len bytes at the stream offset and returns a pointer to them, or
+ * throws BinaryDataException and returns NULL when fewer bytes are left
+ */
+const char *binarystream_read_ptr(zval *stream, size_t len)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+	zend_long remaining = offset < 0 || (size_t) offset > size ? 0 : (zend_long) (size - (size_t) offset);
+
+	if (UNEXPECTED((size_t) remaining < len)) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Not enough bytes left in buffer: need %zu, have " ZEND_LONG_FMT, len, remaining);
+		return NULL;
+	}
+	if (UNEXPECTED(len == 0)) {
+		return remaining ? bytes + offset : bytes + size;
+	}
+	stream_set_offset(obj, offset + (zend_long) len);
+	return bytes + offset;
+}
+
+const char *binarystream_cursor(zval *stream, size_t *len, zend_long *offset)
+{
+	*offset = stream_offset(Z_OBJ_P(stream));
+	return stream_bytes(Z_OBJ_P(stream), len);
+}
+
+void binarystream_seek(zval *stream, zend_long offset)
+{
+	stream_set_offset(Z_OBJ_P(stream), offset);
+}
+
+/**
+ * Returns len bytes at offset of the stream as a string, sharing the backing
+ * string instead of copying when the range covers all of it
+ */
+static zend_string *stream_substr(zend_object *obj, const char *bytes, size_t offset, size_t len)
+{
+	binarystream_object *intern = binarystream_fetch(obj);
+	zend_string *whole;
+	zval *zv;
+
+	if (intern->view) {
+		whole = GC_TYPE(intern->view_owner) == IS_STRING ? (zend_string *) intern->view_owner : NULL;
+	} else {
+		zv = stream_buffer_slot(obj);
+		whole = Z_TYPE_P(zv) == IS_STRING ? Z_STR_P(zv) : NULL;
+	}
+	if (whole != NULL && bytes + offset == ZSTR_VAL(whole) && len == ZSTR_LEN(whole)) {
+		return zend_string_copy(whole);
+	}
+	return zend_string_init(bytes + offset, len, 0);
+}
+
+int binarystream_get(zval *return_value, zval *stream, zval *len_zv)
+{
+	zend_long len = zval_get_long(len_zv);
+	const char *ptr;
+
+	if (len == 0) {
+		ZVAL_EMPTY_STRING(return_value);
+		return SUCCESS;
+	}
+	if (len < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Length must be positive"));
+		return FAILURE;
+	}
+	ptr = binarystream_read_ptr(stream, (size_t) len);
+	if (UNEXPECTED(ptr == NULL)) {
+		return FAILURE;
+	}
+	if (len == 1) {
+		ZVAL_INTERNED_STR(return_value, ZSTR_CHAR((unsigned char) *ptr));
+		return SUCCESS;
+	}
+	ZVAL_STR(return_value, stream_substr(Z_OBJ_P(stream), ptr, 0, (size_t) len));
+	return SUCCESS;
+}
+
+int binarystream_get_remaining(zval *return_value, zval *stream)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+
+	if (offset < 0 || (size_t) offset >= size) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("No bytes left to read"));
+		return FAILURE;
+	}
+	ZVAL_STR(return_value, stream_substr(obj, bytes, (size_t) offset, size - (size_t) offset));
+	stream_set_offset(obj, (zend_long) size);
+	return SUCCESS;
+}
+
+int binarystream_feof(zval *return_value, zval *stream)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+
+	stream_bytes(obj, &size);
+	ZVAL_BOOL(return_value, offset < 0 || (size_t) offset >= size);
+	return SUCCESS;
+}
+
+/**
+ * Returns the string or mapped file the bytes of the stream live in
+ */
+static zend_refcounted *stream_owner(zend_object *obj)
+{
+	binarystream_object *intern = binarystream_fetch(obj);
+	zval *zv;
+
+	if (intern->view) {
+		return intern->view_owner;
+	}
+	zv = stream_buffer_slot(obj);
+	return (zend_refcounted *) (Z_TYPE_P(zv) == IS_STRING ? Z_STR_P(zv) : ZSTR_EMPTY_ALLOC());
+}
+
+zend_refcounted *binarystream_pin(zval *value, const char **bytes, size_t *len)
+{
+	zend_refcounted *owner;
+
+	ZVAL_DEREF(value);
+	if (Z_TYPE_P(value) == IS_STRING) {
+		owner = (zend_refcounted *) Z_STR_P(value);
+		*bytes = Z_STRVAL_P(value);
+		*len = Z_STRLEN_P(value);
+	} else if (Z_TYPE_P(value) == IS_OBJECT && instanceof_function(Z_OBJCE_P(value), pocketmine_utils_binarystream_ce)) {
+		*bytes = stream_bytes(Z_OBJ_P(value), len);
+		owner = stream_owner(Z_OBJ_P(value));
+	} else {
+		return NULL;
+	}
+	owner_addref(owner);
+	return owner;
+}
+
+void binarystream_unpin(zend_refcounted *owner)
+{
+	owner_release(owner);
+}
+
+/**
+ * Creates a BinaryStream reading len bytes of owner at ptr
+ */
+static void stream_new_view(zval *return_value, zend_refcounted *owner, const char *ptr, size_t len)
+{
+	binarystream_object *child;
+
+	object_init_ex(return_value, pocketmine_utils_binarystream_ce);
+	child = binarystream_fetch(Z_OBJ_P(return_value));
+	stream_set_view(child, owner, ptr, len);
+	stream_set_offset(&child->std, 0);
+}
+
+/**
+ * BinaryStream::fromFile(path, access): returns a stream reading a file
+ * through a read-only shared mapping, owned by the file stream, instead of
+ * reading it into a string. Its slices view the mapping as well; writing to
+ * the stream or reading its buffer property copies the bytes like for any
+ * view. Files that cannot be mapped, such as empty files or files of stream
+ * wrappers without mmap support, are read into memory instead.
+ */
+int binarystream_from_file(zval *return_value, zval *path, zval *access)
+{
+	php_stream *file;
+	char *mapped;
+	size_t len = 0;
+	zend_string *contents;
+	zend_long mode = zval_get_long(access);
+
+	if (Z_TYPE_P(path) != IS_STRING) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Path must be a string"));
+		return FAILURE;
+	}
+	if (mode < BINARYSTREAM_ACCESS_NORMAL || mode > BINARYSTREAM_ACCESS_WILLNEED) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown access pattern " ZEND_LONG_FMT, mode);
+		return FAILURE;
+	}
+	file = php_stream_open_wrapper(Z_STRVAL_P(path), "rb", REPORT_ERRORS, NULL);
+	if (file == NULL) {
+		zephir_throw_exception_format(spl_ce_RuntimeException, "Unable to open %s", Z_STRVAL_P(path));
+		return FAILURE;
+	}
+
+	mapped = php_stream_mmap_range(file, 0, PHP_STREAM_MMAP_ALL, PHP_STREAM_MAP_MODE_SHARED_READONLY, &len);
+	if (mapped != NULL && len > 0) {
+#ifndef PHP_WIN32
+		static const int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED};
+
+		/* only a hint for the page cache, a failure changes nothing */
+		madvise(mapped, len, advice[mode]);
+#endif
+		stream_new_view(return_value, (zend_refcounted *) file->res, mapped, len);
+		/* the views hold the file stream now */
+		zend_list_delete(file->res);
+		return SUCCESS;
+	}
+
+	contents = php_stream_copy_to_mem(file, PHP_STREAM_COPY_ALL, 0);
+	php_stream_close(file);
+	if (contents == NULL) {
+		contents = ZSTR_EMPTY_ALLOC();
+	}
+	stream_new_view(return_value, (zend_refcounted *) contents, ZSTR_VAL(contents), ZSTR_LEN(contents));
+	zend_string_release(contents);
+	return SUCCESS;
+}
+
+#ifndef PHP_WIN32
+/* iovecs handed to one writev() call */
+#define BINARYSTREAM_IOV_BATCH 64
+
+/**
+ * Whether writing to the descriptor of a stream is the same as writing to the
+ * stream: pipes and stream sockets without filters or TLS in between. Seekable
+ * files are not, their read buffer may have moved the descriptor past the
+ * stream position and the position must follow the write.
+ */
+static int stream_fd_writable(php_stream *out)
+{
+	static const char *const labels[] = {"tcp_socket", "unix_socket", "generic_socket"};
+	size_t i;
+
+	if (out->writefilters.head != NULL) {
+		return 0;
+	}
+	if (strcmp(out->ops->label, "STDIO") == 0) {
+		return (out->flags & PHP_STREAM_FLAG_NO_SEEK) != 0;
+	}
+	for (i = 0; i < sizeof(labels) / sizeof(labels[0]); i++) {
+		if (strcmp(out->ops->label, labels[i]) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Writes the pieces of the stream to fd with writev(), batching up to
+ * BINARYSTREAM_IOV_BATCH pieces per call. Stops early when a non-blocking
+ * descriptor is full; returns the bytes written, or -1 after throwing.
+ */
+static zend_long stream_writev(zval *stream, int fd)
+{
+	struct iovec iov[BINARYSTREAM_IOV_BATCH];
+	const char *ptr;
+	size_t piece = 0, skip = 0, from, len, i;
+	zend_long written = 0;
+	ssize_t n;
+	int count;
+
+	for (;;) {
+		count = 0;
+		for (i = piece, from = skip; count < BINARYSTREAM_IOV_BATCH && (ptr = binarystream_piece(stream, i, &len)) != NULL; i++, from = 0) {
+			if (len > from) {
+				iov[count].iov_base = (void *) (ptr + from);
+				iov[count].iov_len = len - from;
+				count++;
+			}
+		}
+		if (count == 0) {
+			return written;
+		}
+		n = writev(fd, iov, count);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return written;
+			}
+			zephir_throw_exception_format(spl_ce_RuntimeException, "Write failed: %s", strerror(errno));
+			return -1;
+		}
+		written += (zend_long) n;
+		/* move past what was written, which may end in the middle of a piece */
+		while (n > 0 && binarystream_piece(stream, piece, &len) != NULL) {
+			if ((size_t) n >= len - skip) {
+				n -= (ssize_t) (len - skip);
+				piece++;
+				skip = 0;
+			} else {
+				skip += (size_t) n;
+				n = 0;
+			}
+		}
+	}
+}
+#endif
+
+/**
+ * BinaryStream::writeTo(handle): writes every byte of the stream to a stream
+ * resource without flattening a segmented stream. Pipes and sockets are
+ * written with writev(), anything else, files included, piece by piece
+ * through the stream layer. The stream is left as it is; returns the number of bytes written,
+ * which is less than the length only when a non-blocking handle is full.
+ */
+int binarystream_write_to(zval *return_value, zval *stream, zval *handle)
+{
+	php_stream *out = NULL;
+	const char *ptr;
+	size_t len, i;
+	zend_long written = 0;
+	ssize_t n;
+#ifndef PHP_WIN32
+	int fd;
+#endif
+
+	ZVAL_DEREF(handle);
+	if (Z_TYPE_P(handle) == IS_RESOURCE) {
+		php_stream_from_zval_no_verify(out, handle);
+	}
+	if (out == NULL) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Expected a stream resource"));
+		return FAILURE;
+	}
+
+#ifndef PHP_WIN32
+	if (stream_fd_writable(out) && php_stream_cast(out, PHP_STREAM_AS_FD_FOR_SELECT | PHP_STREAM_CAST_INTERNAL, (void **) &fd, 0) == SUCCESS) {
+		php_stream_flush(out);
+		written = stream_writev(stream, fd);
+		if (written < 0) {
+			return FAILURE;
+		}
+		ZVAL_LONG(return_value, written);
+		return SUCCESS;
+	}
+#endif
+
+	for (i = 0; (ptr = binarystream_piece(stream, i, &len)) != NULL; i++) {
+		if (len == 0) {
+			continue;
+		}
+		n = (ssize_t) php_stream_write(out, ptr, len);
+		if (n > 0) {
+			written += (zend_long) n;
+		}
+		if (n < 0 || (size_t) n < len) {
+			break;
+		}
+	}
+	ZVAL_LONG(return_value, written);
+	return SUCCESS;
+}
+
+/**
+ * Consumes len bytes and returns a new BinaryStream viewing them. The bytes
+ * are shared with this stream's buffer and only copied when the new stream is
+ * written to or its buffer property is read.
+ */
+int binarystream_slice(zval *return_value, zval *stream, zval *len_zv)
+{
+	zend_long len = zval_get_long(len_zv);
+	const char *ptr;
+
+	if (len < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Length must be positive"));
+		return FAILURE;
+	}
+	ptr = binarystream_read_ptr(stream, (size_t) len);
+	if (UNEXPECTED(ptr == NULL)) {
+		return FAILURE;
+	}
+	stream_new_view(return_value, stream_owner(Z_OBJ_P(stream)), ptr, (size_t) len);
+	return SUCCESS;
+}
+
+static zend_always_inline void fixed_decode(zval *return_value, const char *ptr, int type)
+{
+	if (binary_fixed_is_float(type)) {
+		ZVAL_DOUBLE(return_value, binary_fixed_load_float((const unsigned char *) ptr, type));
+	} else {
+		ZVAL_LONG(return_value, (zend_long) binary_fixed_load_int((const unsigned char *) ptr, type));
+	}
+}
+
+static zend_always_inline void fixed_encode(char *ptr, zval *value, int type)
+{
+	if (binary_fixed_is_float(type)) {
+		binary_fixed_store_float((unsigned char *) ptr, Z_TYPE_P(value) == IS_DOUBLE ? Z_DVAL_P(value) : zval_get_double(value), type);
+	} else {
+		binary_fixed_store_int((unsigned char *) ptr, Z_TYPE_P(value) == IS_LONG ? Z_LVAL_P(value) : zval_get_long(value), type);
+	}
+}
+
+/**
+ * BinaryStream::get<Type>(), e.g. binarystream_get_fixed(this, "lshort")
+ */
+int binarystream_get_fixed(zval *return_value, zval *stream, int type)
+{
+	const char *ptr = binarystream_read_ptr(stream, binary_fixed_size(type));
+
+	if (UNEXPECTED(ptr == NULL)) {
+		return FAILURE;
+	}
+	fixed_decode(return_value, ptr, type);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::put<Type>(), e.g. binarystream_put_fixed(this, v, "lshort")
+ */
+int binarystream_put_fixed(zval *return_value, zval *stream, zval *value, int type)
+{
+	fixed_encode(stream_append(Z_OBJ_P(stream), binary_fixed_size(type)), value, type);
+	return SUCCESS;
+}
+
+/**
+ * Binary::read<Type>(); bytes after the value are ignored like unpack() does
+ */
+int binary_read_fixed(zval *return_value, zval *str, int type)
+{
+	size_t size = binary_fixed_size(type);
+	zend_string *tmp = NULL;
+	const char *bytes;
+	size_t len;
+
+	if (EXPECTED(Z_TYPE_P(str) == IS_STRING)) {
+		bytes = Z_STRVAL_P(str);
+		len = Z_STRLEN_P(str);
+	} else {
+		tmp = zval_get_string(str);
+		bytes = ZSTR_VAL(tmp);
+		len = ZSTR_LEN(tmp);
+	}
+	if (UNEXPECTED(len < size)) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Not enough bytes: need %zu, have %zu", size, len);
+		if (tmp) {
+			zend_string_release(tmp);
+		}
+		return FAILURE;
+	}
+	fixed_decode(return_value, bytes, type);
+	if (tmp) {
+		zend_string_release(tmp);
+	}
+	return SUCCESS;
+}
+
+/**
+ * Binary::write<Type>()
+ */
+int binary_write_fixed(zval *return_value, zval *value, int type)
+{
+	size_t size = binary_fixed_size(type);
+	zend_string *str = zend_string_alloc(size, 0);
+
+	fixed_encode(ZSTR_VAL(str), value, type);
+	ZSTR_VAL(str)[size] = '\0';
+	ZVAL_NEW_STR(return_value, str);
+	return SUCCESS;
+}
+
+/**
+ * Reads the byte length of count values of size bytes, throwing when the
+ * stream holds fewer
+ */
+static const char *read_array_bytes(zval *stream, zval *count_zv, size_t size, size_t *count)
+{
+	zend_long n = zval_get_long(count_zv);
+
+	if (n < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Count must be positive"));
+		return NULL;
+	}
+	*count = (size_t) n;
+	return binarystream_read_ptr(stream, (size_t) n > SIZE_MAX / size ? SIZE_MAX : (size_t) n * size);
+}
+
+/**
+ * BinaryStream::get<Type>Array(count): count values decoded into a packed array
+ */
+int binarystream_get_fixed_array(zval *return_value, zval *stream, zval *count_zv, int type)
+{
+	size_t size = binary_fixed_size(type), count, n, i;
+	const char *ptr = read_array_bytes(stream, count_zv, size, &count);
+	union {
+		double d[BINARY_BLOCK];
+		int64_t l[BINARY_BLOCK];
+	} block;
+	int is_float = binary_fixed_is_float(type);
+	zval tmp;
+
+	if (UNEXPECTED(ptr == NULL)) {
+		return FAILURE;
+	}
+	array_init_size(return_value, (uint32_t) count);
+	if (count == 0) {
+		return SUCCESS;
+	}
+	zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+	ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(return_value)) {
+		while (count > 0) {
+			n = count < BINARY_BLOCK ? count : BINARY_BLOCK;
+			if (is_float) {
+				binary_fixed_load_float_block(block.d, (const unsigned char *) ptr, n, type);
+				for (i = 0; i < n; i++) {
+					ZVAL_DOUBLE(&tmp, block.d[i]);
+					ZEND_HASH_FILL_ADD(&tmp);
+				}
+			} else {
+				binary_fixed_load_int_block(block.l, (const unsigned char *) ptr, n, type);
+				for (i = 0; i < n; i++) {
+					ZVAL_LONG(&tmp, (zend_long) block.l[i]);
+					ZEND_HASH_FILL_ADD(&tmp);
+				}
+			}
+			ptr += n * size;
+			count -= n;
+		}
+	} ZEND_HASH_FILL_END();
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::put<Type>Array(values): writes the values of an array in order
+ */
+int binarystream_put_fixed_array(zval *return_value, zval *stream, zval *values, int type)
+{
+	size_t size = binary_fixed_size(type), n = 0;
+	union {
+		double d[BINARY_BLOCK];
+		int64_t l[BINARY_BLOCK];
+	} block;
+	int is_float = binary_fixed_is_float(type);
+	unsigned char *dst;
+	zval *value;
+
+	if (UNEXPECTED(Z_TYPE_P(values) != IS_ARRAY)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Values must be an array"));
+		return FAILURE;
+	}
+	if (zend_hash_num_elements(Z_ARRVAL_P(values)) == 0) {
+		return SUCCESS;
+	}
+	dst = (unsigned char *) stream_append(Z_OBJ_P(stream), zend_hash_num_elements(Z_ARRVAL_P(values)) * size);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(values), value) {
+		ZVAL_DEREF(value);
+		if (is_float) {
+			block.d[n++] = Z_TYPE_P(value) == IS_DOUBLE ? Z_DVAL_P(value) : zval_get_double(value);
+		} else {
+			block.l[n++] = Z_TYPE_P(value) == IS_LONG ? Z_LVAL_P(value) : zval_get_long(value);
+		}
+		if (n == BINARY_BLOCK) {
+			if (is_float) {
+				binary_fixed_store_float_block(dst, block.d, n, type);
+			} else {
+				binary_fixed_store_int_block(dst, block.l, n, type);
+			}
+			dst += n * size;
+			n = 0;
+		}
+	} ZEND_HASH_FOREACH_END();
+	if (is_float) {
+		binary_fixed_store_float_block(dst, block.d, n, type);
+	} else {
+		binary_fixed_store_int_block(dst, block.l, n, type);
+	}
+	return SUCCESS;
+}
+
+/**
+ * Throws the BinaryDataException matching a failed varint decode
+ */
+static void throw_varint_error(int status, int is_long)
+{
+	if (status == BINARY_EOF) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("No bytes left in buffer"));
+	} else if (is_long) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("VarLong did not terminate after 10 bytes!"));
+	} else {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("VarInt did not terminate after 5 bytes!"));
+	}
+}
+
+/**
+ * Decodes a varint from bytes at *offset; offsets outside the buffer read as EOF
+ */
+static zend_always_inline int read_varint(const char *bytes, size_t size, zend_long *offset, uint64_t *out, int is_long)
+{
+	size_t pos;
+	uint32_t value32;
+	int status;
+
+	if (*offset < 0 || (size_t) *offset >= size) {
+		throw_varint_error(BINARY_EOF, is_long);
+		return FAILURE;
+	}
+	pos = (size_t) *offset;
+	if (is_long) {
+		status = varint_read_u64((const unsigned char *) bytes, size, &pos, out);
+	} else {
+		status = varint_read_u32((const unsigned char *) bytes, size, &pos, &value32);
+		*out = value32;
+	}
+	if (UNEXPECTED(status != BINARY_OK)) {
+		throw_varint_error(status, is_long);
+		return FAILURE;
+	}
+	*offset = (zend_long) pos;
+	return SUCCESS;
+}
+
+static zend_always_inline int stream_read_varint(zval *stream, uint64_t *out, int is_long)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+
+	if (read_varint(bytes, size, &offset, out, is_long) == FAILURE) {
+		return FAILURE;
+	}
+	stream_set_offset(obj, offset);
+	return SUCCESS;
+}
+
+int binarystream_get_unsigned_varint(zval *return_value, zval *stream)
+{
+	uint64_t raw;
+
+	if (stream_read_varint(stream, &raw, 0) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, (zend_long) raw);
+	return SUCCESS;
+}
+
+int binarystream_get_varint(zval *return_value, zval *stream)
+{
+	uint64_t raw;
+
+	if (stream_read_varint(stream, &raw, 0) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, zigzag_decode32((uint32_t) raw));
+	return SUCCESS;
+}
+
+int binarystream_get_unsigned_varlong(zval *return_value, zval *stream)
+{
+	uint64_t raw;
+
+	if (stream_read_varint(stream, &raw, 1) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, (zend_long) raw);
+	return SUCCESS;
+}
+
+int binarystream_get_varlong(zval *return_value, zval *stream)
+{
+	uint64_t raw;
+
+	if (stream_read_varint(stream, &raw, 1) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, zigzag_decode64(raw));
+	return SUCCESS;
+}
+
+static int stream_read_varint_array(zval *return_value, zval *stream, zval *count_zv, int zigzag)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj), n = zval_get_long(count_zv);
+	size_t size, pos, count, chunk, i;
+	const char *bytes = stream_bytes(obj, &size);
+	uint32_t block[BINARY_BLOCK];
+	zval tmp;
+	int status = BINARY_OK;
+
+	if (n < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Count must be positive"));
+		return FAILURE;
+	}
+	count = (size_t) n;
+	if (offset < 0 || (size_t) offset > size) {
+		throw_varint_error(BINARY_EOF, 0);
+		return FAILURE;
+	}
+	pos = (size_t) offset;
+	if (count > size - pos) {
+		/*
+		 * every varint takes at least one byte so this can't succeed; decode
+		 * what is left without keeping it to throw what the first bad varint
+		 * would have thrown from getUnsignedVarInt()
+		 */
+		while ((status = varint_read_u32((const unsigned char *) bytes, size, &pos, block)) == BINARY_OK);
+		throw_varint_error(status, 0);
+		return FAILURE;
+	}
+
+	array_init_size(return_value, (uint32_t) count);
+	if (count == 0) {
+		return SUCCESS;
+	}
+	zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+	ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(return_value)) {
+		while (count > 0) {
+			chunk = count < BINARY_BLOCK ? count : BINARY_BLOCK;
+			status = varint_read_u32_array((const unsigned char *) bytes, size, &pos, block, chunk);
+			if (UNEXPECTED(status != BINARY_OK)) {
+				break;
+			}
+			for (i = 0; i < chunk; i++) {
+				ZVAL_LONG(&tmp, zigzag ? (zend_long) zigzag_decode32(block[i]) : (zend_long) block[i]);
+				ZEND_HASH_FILL_ADD(&tmp);
+			}
+			count -= chunk;
+		}
+	} ZEND_HASH_FILL_END();
+
+	if (UNEXPECTED(count > 0)) {
+		zval_ptr_dtor(return_value);
+		ZVAL_NULL(return_value);
+		throw_varint_error(status, 0);
+		return FAILURE;
+	}
+	stream_set_offset(obj, (zend_long) pos);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::getUnsignedVarIntArray(count)
+ */
+int binarystream_get_unsigned_varint_array(zval *return_value, zval *stream, zval *count)
+{
+	return stream_read_varint_array(return_value, stream, count, 0);
+}
+
+/**
+ * BinaryStream::getVarIntArray(count)
+ */
+int binarystream_get_varint_array(zval *return_value, zval *stream, zval *count)
+{
+	return stream_read_varint_array(return_value, stream, count, 1);
+}
+
+static int stream_write_varint_array(zval *stream, zval *values, int zigzag)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zend_string *buf;
+	unsigned char *dst, *start;
+	zend_long v;
+	zval *value;
+
+	if (UNEXPECTED(Z_TYPE_P(values) != IS_ARRAY)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Values must be an array"));
+		return FAILURE;
+	}
+	if (zend_hash_num_elements(Z_ARRVAL_P(values)) == 0) {
+		return SUCCESS;
+	}
+	buf = stream_reserve(intern, (size_t) zend_hash_num_elements(Z_ARRVAL_P(values)) * VARINT_MAX_BYTES);
+	start = dst = (unsigned char *) ZSTR_VAL(buf) + ZSTR_LEN(buf);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(values), value) {
+		ZVAL_DEREF(value);
+		v = Z_TYPE_P(value) == IS_LONG ? Z_LVAL_P(value) : zval_get_long(value);
+		dst += varint_write_u32(dst, zigzag ? zigzag_encode32((int32_t) v) : (uint32_t) v);
+	} ZEND_HASH_FOREACH_END();
+
+	ZSTR_LEN(buf) += (size_t) (dst - start);
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::putUnsignedVarIntArray(values)
+ */
+int binarystream_put_unsigned_varint_array(zval *return_value, zval *stream, zval *values)
+{
+	return stream_write_varint_array(stream, values, 0);
+}
+
+/**
+ * BinaryStream::putVarIntArray(values)
+ */
+int binarystream_put_varint_array(zval *return_value, zval *stream, zval *values)
+{
+	return stream_write_varint_array(stream, values, 1);
+}
+
+/**
+ * Binary::read*Var*() take the buffer by value and the offset by reference
+ */
+static zend_always_inline int read_varint_ref(zval *buffer, zval *offset_ref, uint64_t *out, int is_long)
+{
+	zend_long offset;
+
+	ZVAL_DEREF(offset_ref);
+	offset = zval_get_long(offset_ref);
+	if (Z_TYPE_P(buffer) != IS_STRING) {
+		throw_varint_error(BINARY_EOF, is_long);
+		return FAILURE;
+	}
+	if (read_varint(Z_STRVAL_P(buffer), Z_STRLEN_P(buffer), &offset, out, is_long) == FAILURE) {
+		return FAILURE;
+	}
+	zval_ptr_dtor(offset_ref);
+	ZVAL_LONG(offset_ref, offset);
+	return SUCCESS;
+}
+
+int binary_read_unsigned_varint(zval *return_value, zval *buffer, zval *offset)
+{
+	uint64_t raw;
+
+	if (read_varint_ref(buffer, offset, &raw, 0) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, (zend_long) raw);
+	return SUCCESS;
+}
+
+int binary_read_varint(zval *return_value, zval *buffer, zval *offset)
+{
+	uint64_t raw;
+
+	if (read_varint_ref(buffer, offset, &raw, 0) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, zigzag_decode32((uint32_t) raw));
+	return SUCCESS;
+}
+
+int binary_read_unsigned_varlong(zval *return_value, zval *buffer, zval *offset)
+{
+	uint64_t raw;
+
+	if (read_varint_ref(buffer, offset, &raw, 1) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, (zend_long) raw);
+	return SUCCESS;
+}
+
+int binary_read_varlong(zval *return_value, zval *buffer, zval *offset)
+{
+	uint64_t raw;
+
+	if (read_varint_ref(buffer, offset, &raw, 1) == FAILURE) {
+		return FAILURE;
+	}
+	ZVAL_LONG(return_value, zigzag_decode64(raw));
+	return SUCCESS;
+}
+
+/**
+ * Binary::<type>Size(): encoded length of value, without encoding it
+ */
+int binary_varint_size(zval *return_value, zval *value, int type)
+{
+	ZVAL_LONG(return_value, (zend_long) varint_size_u64(binary_varint_raw(zval_get_long(value), type)));
+	return SUCCESS;
+}
+
+/**
+ * Binary::write<Type>(): sizes the string up front and encodes into it
+ */
+int binary_write_varint(zval *return_value, zval *value, int type)
+{
+	uint64_t raw = binary_varint_raw(zval_get_long(value), type);
+	size_t size = varint_size_u64(raw);
+	zend_string *str = zend_string_alloc(size, 0);
+
+	varint_write_u64((unsigned char *) ZSTR_VAL(str), raw);
+	ZSTR_VAL(str)[size] = '\0';
+	ZVAL_NEW_STR(return_value, str);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::put<Type>(): encodes straight into the stream's buffer
+ */
+int binarystream_put_varint(zval *return_value, zval *stream, zval *value, int type)
+{
+	binarystream_write_varint(stream, binary_varint_raw(zval_get_long(value), type));
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::splitLengthPrefixed(): reads unsigned varint length prefixed
+ * payloads up to the end of the stream and returns them as slices sharing
+ * this stream's bytes. Nothing is consumed when the data is malformed.
+ */
+int binarystream_split_length_prefixed(zval *return_value, zval *stream)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+	zend_refcounted *owner = stream_owner(obj);
+	uint64_t len;
+	zval slice;
+
+	array_init(return_value);
+	while (offset >= 0 && (size_t) offset < size) {
+		if (read_varint(bytes, size, &offset, &len, 0) == FAILURE) {
+			goto error;
+		}
+		if (len > size - (size_t) offset) {
+			zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Not enough bytes left in buffer: need %zu, have %zu", (size_t) len, size - (size_t) offset);
+			goto error;
+		}
+		stream_new_view(&slice, owner, bytes + offset, (size_t) len);
+		zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &slice);
+		offset += (zend_long) len;
+	}
+	stream_set_offset(obj, offset);
+	return SUCCESS;
+
+error:
+	zval_ptr_dtor(return_value);
+	ZVAL_NULL(return_value);
+	return FAILURE;
+}
+
+/**
+ * BinaryStream::joinLengthPrefixed(packets): appends each payload behind its
+ * unsigned varint length, growing the buffer once for the whole batch
+ */
+int binarystream_join_length_prefixed(zval *return_value, zval *stream, zval *packets)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zend_string *buf;
+	unsigned char *dst;
+	const char *bytes;
+	size_t total = 0, len;
+	zval *payload;
+
+	if (UNEXPECTED(Z_TYPE_P(packets) != IS_ARRAY)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Packets must be an array"));
+		return FAILURE;
+	}
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(packets), payload) {
+		bytes = binarystream_bytes_of(payload, &len);
+		if (bytes == NULL) {
+			zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Packets must be strings or BinaryStreams"));
+			return FAILURE;
+		}
+		if (len > UINT32_MAX) {
+			zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Packet is too large to be length prefixed"));
+			return FAILURE;
+		}
+		total += varint_size_u32((uint32_t) len) + len;
+	} ZEND_HASH_FOREACH_END();
+	if (total == 0) {
+		return SUCCESS;
+	}
+
+	/* may copy a payload that views this stream's own buffer, so look the bytes up again below */
+	buf = stream_reserve(intern, total);
+	dst = (unsigned char *) ZSTR_VAL(buf) + ZSTR_LEN(buf);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(packets), payload) {
+		bytes = binarystream_bytes_of(payload, &len);
+		dst += varint_write_u32(dst, (uint32_t) len);
+		memcpy(dst, bytes, len);
+		dst += len;
+	} ZEND_HASH_FOREACH_END();
+
+	ZSTR_LEN(buf) += total;
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+	return SUCCESS;
+}
+
+/**
+ * Consumes an unsigned varint length and that many bytes, returning the
+ * bytes. The length is checked against max_length (unless negative) and the
+ * bytes left before anything is allocated; nothing is consumed on failure.
+ */
+static const char *stream_read_string(zval *stream, zval *max_length, size_t *len)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj), max = zval_get_long(max_length);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+	uint64_t raw;
+
+	if (read_varint(bytes, size, &offset, &raw, 0) == FAILURE) {
+		return NULL;
+	}
+	if (max >= 0 && raw > (uint64_t) max) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "String length %zu exceeds the maximum of " ZEND_LONG_FMT " bytes", (size_t) raw, max);
+		return NULL;
+	}
+	if (raw > size - (size_t) offset) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Not enough bytes left in buffer: need %zu, have %zu", (size_t) raw, size - (size_t) offset);
+		return NULL;
+	}
+	*len = (size_t) raw;
+	stream_set_offset(obj, offset + (zend_long) raw);
+	return bytes + offset;
+}
+
+int binarystream_get_string(zval *return_value, zval *stream, zval *max_length)
+{
+	size_t len;
+	const char *ptr = stream_read_string(stream, max_length, &len);
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	if (len <= 1) {
+		ZVAL_INTERNED_STR(return_value, len ? ZSTR_CHAR((unsigned char) *ptr) : ZSTR_EMPTY_ALLOC());
+	} else {
+		ZVAL_STR(return_value, stream_substr(Z_OBJ_P(stream), ptr, 0, len));
+	}
+	return SUCCESS;
+}
+
+int binarystream_get_string_slice(zval *return_value, zval *stream, zval *max_length)
+{
+	size_t len;
+	const char *ptr = stream_read_string(stream, max_length, &len);
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	stream_new_view(return_value, stream_owner(Z_OBJ_P(stream)), ptr, len);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::putString(str): appends the unsigned varint length and the
+ * bytes with a single reservation
+ */
+int binarystream_put_string(zval *return_value, zval *stream, zval *str)
+{
+	zend_string *tmp = zval_get_string(str), *buf;
+	size_t len = ZSTR_LEN(tmp);
+	unsigned char *dst;
+
+	if (len > UINT32_MAX) {
+		zend_string_release(tmp);
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("String is too large to be length prefixed"));
+		return FAILURE;
+	}
+	buf = stream_reserve(binarystream_fetch(Z_OBJ_P(stream)), VARINT_MAX_BYTES + len);
+	dst = (unsigned char *) ZSTR_VAL(buf) + ZSTR_LEN(buf);
+	dst += varint_write_u32(dst, (uint32_t) len);
+	memcpy(dst, ZSTR_VAL(tmp), len);
+	ZSTR_LEN(buf) = (char *) dst + len - ZSTR_VAL(buf);
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+	zend_string_release(tmp);
+	return SUCCESS;
+}
+
+/*
+ * UUIDs are sent as two little-endian longs, most significant half first, so
+ * the wire form is the canonical big-endian form with each half reversed.
+ */
+#define UUID_SIZE 16
+
+static zend_always_inline void uuid_swap(unsigned char *dst, const unsigned char *src)
+{
+	store_be64(dst, load_le64(src));
+	store_be64(dst + 8, load_le64(src + 8));
+}
+
+static void uuid_value(zval *result, const char *wire, int as_string)
+{
+	static const char digits[] = "0123456789abcdef";
+	unsigned char raw[UUID_SIZE];
+	zend_string *str;
+	char *p;
+	int i;
+
+	uuid_swap(raw, (const unsigned char *) wire);
+	if (!as_string) {
+		ZVAL_STRINGL(result, (const char *) raw, UUID_SIZE);
+		return;
+	}
+	str = zend_string_alloc(36, 0);
+	p = ZSTR_VAL(str);
+	for (i = 0; i < UUID_SIZE; i++) {
+		if (i == 4 || i == 6 || i == 8 || i == 10) {
+			*p++ = '-';
+		}
+		*p++ = digits[raw[i] >> 4];
+		*p++ = digits[raw[i] & 0xf];
+	}
+	*p = '\0';
+	ZVAL_NEW_STR(result, str);
+}
+
+static zend_always_inline int hex_value(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	c |= 0x20;
+	return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+/**
+ * Encodes 16 raw bytes or the hex form, with or without dashes, into wire
+ */
+static int uuid_parse(zval *value, char *wire)
+{
+	unsigned char raw[UUID_SIZE];
+	const char *p;
+	size_t len, i;
+	int hi, lo;
+
+	ZVAL_DEREF(value);
+	if (Z_TYPE_P(value) != IS_STRING) {
+		goto invalid;
+	}
+	p = Z_STRVAL_P(value);
+	len = Z_STRLEN_P(value);
+	if (len == UUID_SIZE) {
+		uuid_swap((unsigned char *) wire, (const unsigned char *) p);
+		return SUCCESS;
+	}
+	if (len != 32 && len != 36) {
+		goto invalid;
+	}
+	for (i = 0; i < UUID_SIZE; i++) {
+		if (len == 36 && (i == 4 || i == 6 || i == 8 || i == 10) && *p++ != '-') {
+			goto invalid;
+		}
+		hi = hex_value(*p++);
+		lo = hex_value(*p++);
+		if ((hi | lo) < 0) {
+			goto invalid;
+		}
+		raw[i] = (unsigned char) (hi << 4 | lo);
+	}
+	uuid_swap((unsigned char *) wire, raw);
+	return SUCCESS;
+
+invalid:
+	zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("UUID must be 16 bytes or 32 hex digits, optionally dashed"));
+	return FAILURE;
+}
+
+int binarystream_get_uuid(zval *return_value, zval *stream, zval *as_string)
+{
+	const char *ptr = binarystream_read_ptr(stream, UUID_SIZE);
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	uuid_value(return_value, ptr, zend_is_true(as_string));
+	return SUCCESS;
+}
+
+int binarystream_get_uuid_array(zval *return_value, zval *stream, zval *count_zv, zval *as_string)
+{
+	size_t count, i;
+	const char *ptr = read_array_bytes(stream, count_zv, UUID_SIZE, &count);
+	int string = zend_is_true(as_string);
+	zval uuid;
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	array_init_size(return_value, (uint32_t) count);
+	for (i = 0; i < count; i++) {
+		uuid_value(&uuid, ptr + i * UUID_SIZE, string);
+		zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &uuid);
+	}
+	return SUCCESS;
+}
+
+int binarystream_put_uuid(zval *return_value, zval *stream, zval *uuid)
+{
+	char wire[UUID_SIZE];
+
+	if (uuid_parse(uuid, wire) == FAILURE) {
+		return FAILURE;
+	}
+	memcpy(stream_append(Z_OBJ_P(stream), UUID_SIZE), wire, UUID_SIZE);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::putUUIDArray(uuids): nothing is written when one of them is invalid
+ */
+int binarystream_put_uuid_array(zval *return_value, zval *stream, zval *uuids)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	size_t total;
+	char *dst;
+	zval *uuid;
+
+	if (UNEXPECTED(Z_TYPE_P(uuids) != IS_ARRAY)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("UUIDs must be an array"));
+		return FAILURE;
+	}
+	total = zend_hash_num_elements(Z_ARRVAL_P(uuids)) * UUID_SIZE;
+	if (total == 0) {
+		return SUCCESS;
+	}
+	dst = stream_append(&intern->std, total);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(uuids), uuid) {
+		if (uuid_parse(uuid, dst) == FAILURE) {
+			/* the buffer is owned after stream_append(), give the space back */
+			ZSTR_LEN(intern->owned) -= total;
+			ZSTR_VAL(intern->owned)[ZSTR_LEN(intern->owned)] = '\0';
+			return FAILURE;
+		}
+		dst += UUID_SIZE;
+	} ZEND_HASH_FOREACH_END();
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::getBlockPosition(): reads varint x, unsigned varint y (or a
+ * varint when signed_y is true) and varint z into an integer Vector3.
+ * Nothing is consumed when one of them is malformed.
+ */
+int binarystream_get_block_position(zval *return_value, zval *stream, zval *signed_y)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+	uint64_t x, y, z;
+
+	if (read_varint(bytes, size, &offset, &x, 0) == FAILURE
+		|| read_varint(bytes, size, &offset, &y, 0) == FAILURE
+		|| read_varint(bytes, size, &offset, &z, 0) == FAILURE
+	) {
+		return FAILURE;
+	}
+	stream_set_offset(obj, offset);
+	vector3_init_long(
+		return_value,
+		zigzag_decode32((uint32_t) x),
+		zend_is_true(signed_y) ? zigzag_decode32((uint32_t) y) : (zend_long) (uint32_t) y,
+		zigzag_decode32((uint32_t) z)
+	);
+	return SUCCESS;
+}
+
+int binarystream_put_block_position(zval *return_value, zval *stream, zval *vector, zval *signed_y)
+{
+	zend_long x, y, z;
+	zend_string *buf;
+	unsigned char *dst;
+
+	if (vector3_floor_components(vector, &x, &y, &z) == FAILURE) {
+		return FAILURE;
+	}
+	buf = stream_reserve(binarystream_fetch(Z_OBJ_P(stream)), 3 * VARINT_MAX_BYTES);
+	dst = (unsigned char *) ZSTR_VAL(buf) + ZSTR_LEN(buf);
+	dst += varint_write_u32(dst, zigzag_encode32((int32_t) x));
+	dst += varint_write_u32(dst, zend_is_true(signed_y) ? zigzag_encode32((int32_t) y) : (uint32_t) y);
+	dst += varint_write_u32(dst, zigzag_encode32((int32_t) z));
+	ZSTR_LEN(buf) = (char *) dst - ZSTR_VAL(buf);
+	ZSTR_VAL(buf)[ZSTR_LEN(buf)] = '\0';
+	zend_string_forget_hash_val(buf);
+	return SUCCESS;
+}
+
+/* Vectors converted per call to the bulk float helpers */
+#define VECTOR3_BLOCK (BINARY_BLOCK / 3)
+
+int binarystream_get_vector3(zval *return_value, zval *stream)
+{
+	const char *ptr = binarystream_read_ptr(stream, 12);
+	double v[3];
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	binary_fixed_load_float_block(v, (const unsigned char *) ptr, 3, BINARY_LFLOAT);
+	vector3_init(return_value, v[0], v[1], v[2]);
+	return SUCCESS;
+}
+
+int binarystream_get_vector3_array(zval *return_value, zval *stream, zval *count_zv)
+{
+	size_t count, i, j, n;
+	const char *ptr = read_array_bytes(stream, count_zv, 12, &count);
+	double block[VECTOR3_BLOCK * 3];
+	zval vector;
+
+	if (ptr == NULL) {
+		return FAILURE;
+	}
+	array_init_size(return_value, (uint32_t) count);
+	for (i = 0; i < count; i += n) {
+		n = count - i < VECTOR3_BLOCK ? count - i : VECTOR3_BLOCK;
+		binary_fixed_load_float_block(block, (const unsigned char *) ptr + i * 12, n * 3, BINARY_LFLOAT);
+		for (j = 0; j < n; j++) {
+			vector3_init(&vector, block[j * 3], block[j * 3 + 1], block[j * 3 + 2]);
+			zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &vector);
+		}
+	}
+	return SUCCESS;
+}
+
+int binarystream_put_vector3(zval *return_value, zval *stream, zval *vector)
+{
+	double v[3];
+
+	if (vector3_components(vector, &v[0], &v[1], &v[2]) == FAILURE) {
+		return FAILURE;
+	}
+	binary_fixed_store_float_block((unsigned char *) stream_append(Z_OBJ_P(stream), 12), v, 3, BINARY_LFLOAT);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::putVector3Array(vectors): nothing is written when one of them is not a Vector3
+ */
+int binarystream_put_vector3_array(zval *return_value, zval *stream, zval *vectors)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	size_t total, n = 0;
+	double block[VECTOR3_BLOCK * 3];
+	unsigned char *dst;
+	zval *vector;
+
+	if (UNEXPECTED(Z_TYPE_P(vectors) != IS_ARRAY)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Vectors must be an array"));
+		return FAILURE;
+	}
+	total = zend_hash_num_elements(Z_ARRVAL_P(vectors)) * 12;
+	if (total == 0) {
+		return SUCCESS;
+	}
+	dst = (unsigned char *) stream_append(&intern->std, total);
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(vectors), vector) {
+		ZVAL_DEREF(vector);
+		if (vector3_components(vector, &block[n * 3], &block[n * 3 + 1], &block[n * 3 + 2]) == FAILURE) {
+			/* the buffer is owned after stream_append(), give the space back */
+			ZSTR_LEN(intern->owned) -= total;
+			ZSTR_VAL(intern->owned)[ZSTR_LEN(intern->owned)] = '\0';
+			return FAILURE;
+		}
+		if (++n == VECTOR3_BLOCK) {
+			binary_fixed_store_float_block(dst, block, n * 3, BINARY_LFLOAT);
+			dst += n * 12;
+			n = 0;
+		}
+	} ZEND_HASH_FOREACH_END();
+	binary_fixed_store_float_block(dst, block, n * 3, BINARY_LFLOAT);
+	return SUCCESS;
+}
+
+/*
+ * Incremental reads: append() adds bytes received so far and the pull*()
+ * readers return null, consuming nothing, when the value they read is not
+ * complete yet. The bytes of a varint cut off by the end of the buffer are
+ * remembered with the offset they start at, so the next pull at that offset
+ * continues behind them.
+ */
+
+/**
+ * Drops the bytes before the offset, which moves back to 0. The buffer is
+ * shifted in place when the stream owns it, otherwise the stream becomes a
+ * view of the unread bytes.
+ */
+static void stream_compact(binarystream_object *intern, size_t consumed)
+{
+	zval *zv;
+	zend_string *buf;
+
+	if (intern->view) {
+		intern->view += consumed;
+		intern->view_len -= consumed;
+	} else {
+		zv = stream_buffer_slot(&intern->std);
+		buf = Z_STR_P(zv);
+		if (buf == intern->owned && GC_REFCOUNT(buf) == 2) {
+			memmove(ZSTR_VAL(buf), ZSTR_VAL(buf) + consumed, ZSTR_LEN(buf) - consumed + 1);
+			ZSTR_LEN(buf) -= consumed;
+			zend_string_forget_hash_val(buf);
+		} else {
+			stream_set_view(intern, (zend_refcounted *) buf, ZSTR_VAL(buf) + consumed, ZSTR_LEN(buf) - consumed);
+		}
+	}
+	if (intern->partial_offset >= 0) {
+		intern->partial_offset -= (zend_long) consumed;
+	}
+	stream_set_offset(&intern->std, 0);
+}
+
+/**
+ * BinaryStream::append(bytes): adds a string or the buffer of another stream
+ * to the end of the buffer. Once at least half of the buffer has been read,
+ * the read bytes are dropped first and the offset moves back by as many bytes.
+ */
+int binarystream_append(zval *return_value, zval *stream, zval *bytes)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+	zend_long offset = stream_offset(&intern->std);
+	const char *src;
+	size_t len, size;
+	/* holding the source keeps its bytes valid when it is this stream's own buffer */
+	zend_refcounted *pinned = binarystream_pin(bytes, &src, &len);
+
+	if (pinned == NULL) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Expected a string or a BinaryStream"));
+		return FAILURE;
+	}
+	stream_bytes(&intern->std, &size);
+	if (offset > 0 && (size_t) offset <= size && (size_t) offset >= size - (size_t) offset) {
+		stream_compact(intern, (size_t) offset);
+	}
+	if (len) {
+		memcpy(stream_append(&intern->std, len), src, len);
+	}
+	binarystream_unpin(pinned);
+	return SUCCESS;
+}
+
+/**
+ * Consumes len bytes like binarystream_read_ptr(), or returns NULL without
+ * throwing when fewer are left
+ */
+static const char *stream_pull_ptr(zval *stream, zend_long len)
+{
+	zend_object *obj = Z_OBJ_P(stream);
+	zend_long offset = stream_offset(obj);
+	size_t size;
+	const char *bytes = stream_bytes(obj, &size);
+
+	if (offset < 0 || (size_t) offset > size || size - (size_t) offset < (size_t) len) {
+		return NULL;
+	}
+	stream_set_offset(obj, offset + len);
+	return bytes + offset;
+}
+
+static int check_pull_length(zval *len_zv, zend_long *len)
+{
+	*len = zval_get_long(len_zv);
+	if (*len < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Length must be positive"));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+int binarystream_pull(zval *return_value, zval *stream, zval *len_zv)
+{
+	zend_long len;
+	const char *ptr;
+
+	if (check_pull_length(len_zv, &len) == FAILURE) {
+		return FAILURE;
+	}
+	ptr = stream_pull_ptr(stream, len);
+	if (ptr == NULL) {
+		ZVAL_NULL(return_value);
+	} else if (len <= 1) {
+		ZVAL_INTERNED_STR(return_value, len ? ZSTR_CHAR((unsigned char) *ptr) : ZSTR_EMPTY_ALLOC());
+	} else {
+		ZVAL_STR(return_value, stream_substr(Z_OBJ_P(stream), ptr, 0, (size_t) len));
+	}
+	return SUCCESS;
+}
+
+int binarystream_pull_slice(zval *return_value, zval *stream, zval *len_zv)
+{
+	zend_long len;
+	const char *ptr;
+
+	if (check_pull_length(len_zv, &len) == FAILURE) {
+		return FAILURE;
+	}
+	ptr = stream_pull_ptr(stream, len);
+	if (ptr == NULL) {
+		ZVAL_NULL(return_value);
+	} else {
+		stream_new_view(return_value, stream_owner(Z_OBJ_P(stream)), ptr, (size_t) len);
+	}
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::pull<Type>(), e.g. binarystream_pull_fixed(this, "lshort")
+ */
+int binarystream_pull_fixed(zval *return_value, zval *stream, int type)
+{
+	const char *ptr = stream_pull_ptr(stream, (zend_long) binary_fixed_size(type));
+
+	if (ptr == NULL) {
+		ZVAL_NULL(return_value);
+	} else {
+		fixed_decode(return_value, ptr, type);
+	}
+	return SUCCESS;
+}
+
+/**
+ * Decodes a varint of type at the offset, resuming a cut off one, and
+ * consumes it. Returns BINARY_EOF, consuming nothing, when the buffer ends
+ * inside it and BINARY_OVERLONG when it is too long.
+ */
+static int stream_pull_varint(binarystream_object *intern, int type, zend_long *value)
+{
+	zend_long offset = stream_offset(&intern->std);
+	int is_long = binary_varint_is_long(type);
+	unsigned max = is_long ? VARLONG_MAX_BYTES : VARINT_MAX_BYTES, n = 0;
+	uint64_t raw = 0;
+	size_t size, avail;
+	const unsigned char *p = (const unsigned char *) stream_bytes(&intern->std, &size);
+	unsigned char b;
+
+	if (offset < 0 || (size_t) offset >= size) {
+		return BINARY_EOF;
+	}
+	p += offset;
+	avail = size - (size_t) offset;
+	if (intern->partial_offset == offset && intern->partial_long == is_long && intern->partial_len <= avail) {
+		raw = intern->partial_value;
+		n = intern->partial_len;
+	}
+	intern->partial_offset = -1;
+	for (; n < max; n++) {
+		if (n == avail) {
+			intern->partial_offset = offset;
+			intern->partial_value = raw;
+			intern->partial_len = (unsigned char) n;
+			intern->partial_long = (unsigned char) is_long;
+			return BINARY_EOF;
+		}
+		b = p[n];
+		raw |= (uint64_t) (b & 0x7f) << (7 * n);
+		if (!(b & 0x80)) {
+			stream_set_offset(&intern->std, offset + n + 1);
+			*value = (zend_long) binary_varint_value(raw, type);
+			return BINARY_OK;
+		}
+	}
+	return BINARY_OVERLONG;
+}
+
+/**
+ * BinaryStream::pull<Type>() for varints, e.g. binarystream_pull_varint(this, "unsigned_varint").
+ * Only a varint longer than its maximum size throws.
+ */
+int binarystream_pull_varint(zval *return_value, zval *stream, int type)
+{
+	zend_long value;
+
+	switch (stream_pull_varint(binarystream_fetch(Z_OBJ_P(stream)), type, &value)) {
+		case BINARY_OK:
+			ZVAL_LONG(return_value, value);
+			return SUCCESS;
+		case BINARY_EOF:
+			ZVAL_NULL(return_value);
+			return SUCCESS;
+		default:
+			throw_varint_error(BINARY_OVERLONG, binary_varint_is_long(type));
+			return FAILURE;
+	}
+}
+
+/*
+ * Exception-free reads: the tryGet*() methods return null when a read fails
+ * and record why and at which offset in the stream instead of throwing, so
+ * junk input costs no exception object or backtrace. The first failure is
+ * kept until clearError().
+ */
+
+static void stream_fail(zval *stream, int error)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+
+	if (intern->error == BINARY_OK) {
+		intern->error = error;
+		intern->error_offset = stream_offset(&intern->std);
+	}
+}
+
+int binarystream_try_get(zval *return_value, zval *stream, zval *len)
+{
+	if (binarystream_pull(return_value, stream, len) == FAILURE) {
+		return FAILURE;
+	}
+	if (Z_TYPE_P(return_value) == IS_NULL) {
+		stream_fail(stream, BINARY_EOF);
+	}
+	return SUCCESS;
+}
+
+int binarystream_try_slice(zval *return_value, zval *stream, zval *len)
+{
+	if (binarystream_pull_slice(return_value, stream, len) == FAILURE) {
+		return FAILURE;
+	}
+	if (Z_TYPE_P(return_value) == IS_NULL) {
+		stream_fail(stream, BINARY_EOF);
+	}
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::tryGet<Type>(), e.g. binarystream_try_get_fixed(this, "lshort")
+ */
+int binarystream_try_get_fixed(zval *return_value, zval *stream, int type)
+{
+	binarystream_pull_fixed(return_value, stream, type);
+	if (Z_TYPE_P(return_value) == IS_NULL) {
+		stream_fail(stream, BINARY_EOF);
+	}
+	return SUCCESS;
+}
+
+/**
+ * BinaryStream::tryGet<Type>() for varints, e.g. binarystream_try_get_varint(this, "varint")
+ */
+int binarystream_try_get_varint(zval *return_value, zval *stream, int type)
+{
+	zend_long value;
+	int status = stream_pull_varint(binarystream_fetch(Z_OBJ_P(stream)), type, &value);
+
+	if (status == BINARY_OK) {
+		ZVAL_LONG(return_value, value);
+	} else {
+		ZVAL_NULL(return_value);
+		stream_fail(stream, status);
+	}
+	return SUCCESS;
+}
+
+int binarystream_last_error(zval *return_value, zval *stream)
+{
+	ZVAL_LONG(return_value, binarystream_fetch(Z_OBJ_P(stream))->error);
+	return SUCCESS;
+}
+
+int binarystream_error_offset(zval *return_value, zval *stream)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+
+	ZVAL_LONG(return_value, intern->error == BINARY_OK ? -1 : intern->error_offset);
+	return SUCCESS;
+}
+
+int binarystream_clear_error(zval *return_value, zval *stream)
+{
+	binarystream_object *intern = binarystream_fetch(Z_OBJ_P(stream));
+
+	intern->error = BINARY_OK;
+	intern->error_offset = 0;
+	return SUCCESS;
+}
@@ -0,0 +1,157 @@
+#ifndef BINARYSTREAM_NATIVE_H
+#define BINARYSTREAM_NATIVE_H
+
+#include <php.h>
+
+#include "binary_native.h"
+
+/**
+ * Bytes referenced by a segmented stream instead of being copied into its buffer
+ */
+typedef struct _binarystream_segment {
+	zend_refcounted *owner; /* string or mapped file holding the bytes */
+	const char *ptr;
+	size_t len;
+} binarystream_segment;
+
+/**
+ * Native part of Pocketmine\Utils\BinaryStream objects
+ */
+typedef struct _binarystream_object {
+	zend_string *owned;  /* buffer string allocated by the stream, growable in place */
+	size_t capacity;     /* bytes allocated for owned; kept across reset() as a size hint */
+	const char *view;    /* window into view_owner read by a slice, NULL when the buffer property holds the bytes */
+	size_t view_len;
+	zend_refcounted *view_owner; /* string or mapped file resource holding the window */
+	zend_long partial_offset;  /* offset of a varint cut off by the end of the buffer, -1 if none */
+	uint64_t partial_value;    /* its bits decoded so far */
+	unsigned char partial_len; /* its bytes decoded so far */
+	unsigned char partial_long;
+	int error;                 /* first failure of a tryGet*() read, a BINARY_* result code */
+	zend_long error_offset;    /* offset it happened at */
+	binarystream_segment *segments; /* bytes in front of the buffer property, flattened before any read */
+	uint32_t segment_count;
+	uint32_t segment_slots;
+	size_t segments_len;
+	size_t segment_threshold;  /* put() references strings of at least this many bytes, 0 to always copy */
+	zend_object std;
+} binarystream_object;
+
+void binarystream_module_init(void);
+
+/* Appends len bytes to the stream and returns where to write them */
+char *binarystream_write_ptr(zval *stream, size_t len);
+/* Creates a BinaryStream over buf, which was allocated with room for capacity bytes and is taken over */
+void binarystream_init_owned(zval *return_value, zend_string *buf, size_t capacity);
+/* Creates an empty BinaryStream with room for capacity bytes, like new BinaryStream() */
+void binarystream_init_empty(zval *return_value, size_t capacity);
+/* Returns the bytes of a string, or the whole buffer of a BinaryStream; NULL for anything else */
+const char *binarystream_bytes_of(zval *value, size_t *len);
+/*
+ * Returns piece i of the bytes of a string or BinaryStream, NULL past the last
+ * one. A segmented stream is returned segment by segment without flattening
+ * it, anything else is a single piece.
+ */
+const char *binarystream_piece(zval *value, size_t i, size_t *len);
+/*
+ * Like binarystream_bytes_of(), also returning a new reference to the string
+ * or mapped file holding the bytes. While it is held the bytes are never
+ * written to, as streams copy a shared buffer before writing. It is given
+ * back with binarystream_unpin() on the thread that pinned it.
+ */
+zend_refcounted *binarystream_pin(zval *value, const char **bytes, size_t *len);
+void binarystream_unpin(zend_refcounted *owner);
+/* Returns the number of bytes written to the stream, without flattening its segments */
+size_t binarystream_length(zval *stream);
+/* Drops the bytes past len, to take back a write that failed halfway */
+void binarystream_truncate(zval *stream, size_t len);
+/* Appends a varint in place; 32-bit values must already be truncated to 32 bits */
+void binarystream_write_varint(zval *stream, uint64_t raw);
+/* Consumes len bytes of the stream and returns them, NULL after throwing if fewer are left */
+const char *binarystream_read_ptr(zval *stream, size_t len);
+/* Returns the bytes of the stream and its offset, for decoders that consume them with binarystream_seek() */
+const char *binarystream_cursor(zval *stream, size_t *len, zend_long *offset);
+void binarystream_seek(zval *stream, zend_long offset);
+
+int binarystream_put(zval *return_value, zval *stream, zval *str);
+int binarystream_put_byte(zval *return_value, zval *stream, zval *value);
+int binarystream_reserve(zval *return_value, zval *stream, zval *len);
+int binarystream_reset(zval *return_value, zval *stream);
+int binarystream_set_segment_threshold(zval *return_value, zval *stream, zval *threshold);
+int binarystream_segment_count(zval *return_value, zval *stream);
+int binarystream_write_to(zval *return_value, zval *stream, zval *handle);
+/* Empties the stream like reset() for reuse, freeing a buffer of more than max_capacity bytes; returns binarystream_retained() */
+size_t binarystream_recycle(zval *stream, size_t max_capacity);
+/* Returns the bytes allocated for the buffer of the stream */
+size_t binarystream_retained(zval *stream);
+
+int binarystream_get(zval *return_value, zval *stream, zval *len);
+int binarystream_get_remaining(zval *return_value, zval *stream);
+int binarystream_feof(zval *return_value, zval *stream);
+int binarystream_slice(zval *return_value, zval *stream, zval *len);
+/* Access patterns of fromFile(), same values as the BinaryStream::ACCESS_* constants */
+#define BINARYSTREAM_ACCESS_NORMAL     0
+#define BINARYSTREAM_ACCESS_SEQUENTIAL 1
+#define BINARYSTREAM_ACCESS_RANDOM     2
+#define BINARYSTREAM_ACCESS_WILLNEED   3
+int binarystream_from_file(zval *return_value, zval *path, zval *access);
+int binarystream_split_length_prefixed(zval *return_value, zval *stream);
+int binarystream_join_length_prefixed(zval *return_value, zval *stream, zval *packets);
+int binarystream_get_string(zval *return_value, zval *stream, zval *max_length);
+int binarystream_get_string_slice(zval *return_value, zval *stream, zval *max_length);
+int binarystream_put_string(zval *return_value, zval *stream, zval *str);
+int binarystream_get_uuid(zval *return_value, zval *stream, zval *as_string);
+int binarystream_get_uuid_array(zval *return_value, zval *stream, zval *count, zval *as_string);
+int binarystream_put_uuid(zval *return_value, zval *stream, zval *uuid);
+int binarystream_put_uuid_array(zval *return_value, zval *stream, zval *uuids);
+int binarystream_get_block_position(zval *return_value, zval *stream, zval *signed_y);
+int binarystream_put_block_position(zval *return_value, zval *stream, zval *vector, zval *signed_y);
+int binarystream_get_vector3(zval *return_value, zval *stream);
+int binarystream_get_vector3_array(zval *return_value, zval *stream, zval *count);
+int binarystream_put_vector3(zval *return_value, zval *stream, zval *vector);
+int binarystream_put_vector3_array(zval *return_value, zval *stream, zval *vectors);
+
+/* type is a binary_fixed_type, see binary_native.h */
+int binarystream_get_fixed(zval *return_value, zval *stream, int type);
+int binarystream_put_fixed(zval *return_value, zval *stream, zval *value, int type);
+int binary_read_fixed(zval *return_value, zval *str, int type);
+int binary_write_fixed(zval *return_value, zval *value, int type);
+int binarystream_get_fixed_array(zval *return_value, zval *stream, zval *count, int type);
+int binarystream_put_fixed_array(zval *return_value, zval *stream, zval *values, int type);
+
+int binarystream_get_unsigned_varint(zval *return_value, zval *stream);
+int binarystream_get_varint(zval *return_value, zval *stream);
+int binarystream_get_unsigned_varlong(zval *return_value, zval *stream);
+int binarystream_get_varlong(zval *return_value, zval *stream);
+int binarystream_get_unsigned_varint_array(zval *return_value, zval *stream, zval *count);
+int binarystream_get_varint_array(zval *return_value, zval *stream, zval *count);
+int binarystream_put_unsigned_varint_array(zval *return_value, zval *stream, zval *values);
+int binarystream_put_varint_array(zval *return_value, zval *stream, zval *values);
+
+/* Incremental reads, returning null instead of throwing when the data is incomplete */
+int binarystream_append(zval *return_value, zval *stream, zval *bytes);
+int binarystream_pull(zval *return_value, zval *stream, zval *len);
+int binarystream_pull_slice(zval *return_value, zval *stream, zval *len);
+int binarystream_pull_fixed(zval *return_value, zval *stream, int type);
+/* type is a binary_varint_type, see binary_native.h */
+int binarystream_pull_varint(zval *return_value, zval *stream, int type);
+
+/* Reads returning null and recording an error code instead of throwing */
+int binarystream_try_get(zval *return_value, zval *stream, zval *len);
+int binarystream_try_slice(zval *return_value, zval *stream, zval *len);
+int binarystream_try_get_fixed(zval *return_value, zval *stream, int type);
+int binarystream_try_get_varint(zval *return_value, zval *stream, int type);
+int binarystream_last_error(zval *return_value, zval *stream);
+int binarystream_error_offset(zval *return_value, zval *stream);
+int binarystream_clear_error(zval *return_value, zval *stream);
+
+int binary_read_unsigned_varint(zval *return_value, zval *buffer, zval *offset);
+int binary_read_varint(zval *return_value, zval *buffer, zval *offset);
+int binary_read_unsigned_varlong(zval *return_value, zval *buffer, zval *offset);
+int binary_read_varlong(zval *return_value, zval *buffer, zval *offset);
+/* type is a binary_varint_type, see binary_native.h */
+int binary_varint_size(zval *return_value, zval *value, int type);
+int binary_write_varint(zval *return_value, zval *value, int type);
+int binarystream_put_varint(zval *return_value, zval *stream, zval *value, int type);
+
+#endif
@@ -0,0 +1,209 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include "binarystream_native.h"
+#include "binarystreampool_native.h"
+
+static zend_object_handlers binarystreampool_handlers;
+
+static zend_always_inline binarystreampool_object *binarystreampool_fetch(zend_object *obj)
+{
+	return (binarystreampool_object *) ((char *) obj - XtOffsetOf(binarystreampool_object, std));
+}
+
+/**
+ * Drops idle streams, the least recently released first, until keep are left
+ */
+static void pool_shrink(binarystreampool_object *intern, uint32_t keep)
+{
+	uint32_t drop, i;
+
+	if (intern->count <= keep) {
+		return;
+	}
+	drop = intern->count - keep;
+	for (i = 0; i < drop; i++) {
+		zval_ptr_dtor(&intern->streams[i]);
+	}
+	memmove(intern->streams, intern->streams + drop, keep * sizeof(zval));
+	intern->count = keep;
+}
+
+static zend_object *binarystreampool_create_object(zend_class_entry *ce)
+{
+	binarystreampool_object *intern = zend_object_alloc(sizeof(binarystreampool_object), ce);
+
+	memset(intern, 0, XtOffsetOf(binarystreampool_object, std));
+	zend_object_std_init(&intern->std, ce);
+	object_properties_init(&intern->std, ce);
+	intern->std.handlers = &binarystreampool_handlers;
+
+	return &intern->std;
+}
+
+static void binarystreampool_free_object(zend_object *obj)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(obj);
+
+	pool_shrink(intern, 0);
+	if (intern->streams) {
+		efree(intern->streams);
+	}
+	zend_object_std_dtor(obj);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zend_object *binarystreampool_clone_object(zend_object *old_obj)
+{
+#else
+static zend_object *binarystreampool_clone_object(zval *object)
+{
+	zend_object *old_obj = Z_OBJ_P(object);
+#endif
+	zend_object *new_obj = binarystreampool_create_object(old_obj->ce);
+	binarystreampool_object *old_intern = binarystreampool_fetch(old_obj);
+	binarystreampool_object *new_intern = binarystreampool_fetch(new_obj);
+
+	/* the clone has the same limits and starts empty */
+	zend_objects_clone_members(new_obj, old_obj);
+	new_intern->max_streams = old_intern->max_streams;
+	new_intern->max_capacity = old_intern->max_capacity;
+
+	return new_obj;
+}
+
+#if PHP_VERSION_ID >= 80000
+static HashTable *binarystreampool_get_gc(zend_object *object, zval **table, int *n)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(object);
+#else
+static HashTable *binarystreampool_get_gc(zval *object, zval **table, int *n)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(Z_OBJ_P(object));
+#endif
+
+	*table = intern->streams;
+	*n = (int) intern->count;
+	return zend_std_get_properties(object);
+}
+
+void binarystreampool_module_init(void)
+{
+	pocketmine_utils_binarystreampool_ce->create_object = binarystreampool_create_object;
+	memcpy(&binarystreampool_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	binarystreampool_handlers.offset = XtOffsetOf(binarystreampool_object, std);
+	binarystreampool_handlers.free_obj = binarystreampool_free_object;
+	binarystreampool_handlers.clone_obj = binarystreampool_clone_object;
+	binarystreampool_handlers.get_gc = binarystreampool_get_gc;
+}
+
+int binarystreampool_configure(zval *return_value, zval *pool, zval *max_streams_zv, zval *max_capacity_zv)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(Z_OBJ_P(pool));
+	zend_long max_streams = zval_get_long(max_streams_zv), max_capacity = zval_get_long(max_capacity_zv);
+
+	if (max_streams < 0 || (zend_ulong) max_streams > UINT32_MAX / sizeof(zval)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum stream count is out of range"));
+		return FAILURE;
+	}
+	if (max_capacity < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum capacity must be positive"));
+		return FAILURE;
+	}
+	intern->max_streams = (uint32_t) max_streams;
+	intern->max_capacity = (size_t) max_capacity;
+	pool_shrink(intern, intern->max_streams);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStreamPool::acquire(): the most recently released stream, whose
+ * buffer is the most likely to still be in the CPU cache, or a new one
+ */
+int binarystreampool_acquire(zval *return_value, zval *pool)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(Z_OBJ_P(pool));
+
+	if (intern->count > 0) {
+		intern->hits++;
+		ZVAL_COPY_VALUE(return_value, &intern->streams[--intern->count]);
+		return SUCCESS;
+	}
+	intern->misses++;
+	binarystream_init_empty(return_value, 0);
+	return SUCCESS;
+}
+
+/**
+ * BinaryStreamPool::release(stream): empties the stream and keeps it, with
+ * its buffer unless that grew beyond the capacity limit, while the pool has room
+ */
+int binarystreampool_release(zval *return_value, zval *pool, zval *stream)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(Z_OBJ_P(pool));
+	uint32_t i;
+
+	if (Z_TYPE_P(stream) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(stream), pocketmine_utils_binarystream_ce)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Expected a BinaryStream"));
+		return FAILURE;
+	}
+	for (i = 0; i < intern->count; i++) {
+		if (Z_OBJ(intern->streams[i]) == Z_OBJ_P(stream)) {
+			zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("The stream was already released"));
+			return FAILURE;
+		}
+	}
+	if (intern->count >= intern->max_streams) {
+		intern->discarded++;
+		return SUCCESS;
+	}
+	binarystream_recycle(stream, intern->max_capacity);
+	if (intern->count == intern->size) {
+		intern->size = intern->size ? intern->size * 2 : 8;
+		if (intern->size > intern->max_streams) {
+			intern->size = intern->max_streams;
+		}
+		intern->streams = safe_erealloc(intern->streams, intern->size, sizeof(zval), 0);
+	}
+	ZVAL_COPY(&intern->streams[intern->count++], stream);
+	return SUCCESS;
+}
+
+int binarystreampool_trim(zval *return_value, zval *pool, zval *keep)
+{
+	zend_long n = zval_get_long(keep);
+
+	if (n < 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Count must be positive"));
+		return FAILURE;
+	}
+	pool_shrink(binarystreampool_fetch(Z_OBJ_P(pool)), n > UINT32_MAX ? UINT32_MAX : (uint32_t) n);
+	return SUCCESS;
+}
+
+int binarystreampool_stats(zval *return_value, zval *pool)
+{
+	binarystreampool_object *intern = binarystreampool_fetch(Z_OBJ_P(pool));
+	size_t retained = 0;
+	uint32_t i;
+
+	for (i = 0; i < intern->count; i++) {
+		retained += binarystream_retained(&intern->streams[i]);
+	}
+	array_init_size(return_value, 5);
+	add_assoc_long(return_value, "hits", intern->hits);
+	add_assoc_long(return_value, "misses", intern->misses);
+	add_assoc_long(return_value, "discarded", intern->discarded);
+	add_assoc_long(return_value, "idle", (zend_long) intern->count);
+	add_assoc_long(return_value, "bytesRetained", (zend_long) retained);
+	return SUCCESS;
+}
@@ -0,0 +1,29 @@
+#ifndef BINARYSTREAMPOOL_NATIVE_H
+#define BINARYSTREAMPOOL_NATIVE_H
+
+#include <php.h>
+
+/**
+ * Native part of Pocketmine\Utils\BinaryStreamPool objects
+ */
+typedef struct _binarystreampool_object {
+	zval *streams;          /* idle streams, the most recently released last */
+	uint32_t count;
+	uint32_t size;          /* slots allocated for streams */
+	uint32_t max_streams;   /* idle streams kept at most */
+	size_t max_capacity;    /* larger buffers are freed on release */
+	zend_long hits;
+	zend_long misses;
+	zend_long discarded;    /* released streams dropped because the pool was full */
+	zend_object std;
+} binarystreampool_object;
+
+void binarystreampool_module_init(void);
+
+int binarystreampool_configure(zval *return_value, zval *pool, zval *max_streams, zval *max_capacity);
+int binarystreampool_acquire(zval *return_value, zval *pool);
+int binarystreampool_release(zval *return_value, zval *pool, zval *stream);
+int binarystreampool_trim(zval *return_value, zval *pool, zval *keep);
+int binarystreampool_stats(zval *return_value, zval *pool);
+
+#endif
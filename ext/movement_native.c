@@ -0,0 +1,152 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include <math.h>
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "movement_native.h"
+
+/* Components of an entity state, in the order of the state lists */
+#define STATE_FIELDS 6
+
+/* Longest packet body: header, runtime ID, flags, three floats and three rotation bytes */
+#define MOVEMENT_MAX_BODY (VARINT_MAX_BYTES + VARLONG_MAX_BYTES + 2 + 3 * 4 + 3)
+
+/**
+ * Reads x, y, z, pitch, yaw and head yaw from the state list of an entity
+ */
+static int read_state(zval *state, zend_ulong id, double out[STATE_FIELDS])
+{
+	zval *zv;
+	int i;
+
+	ZVAL_DEREF(state);
+	if (Z_TYPE_P(state) == IS_ARRAY) {
+		for (i = 0; i < STATE_FIELDS; i++) {
+			if ((zv = zend_hash_index_find(Z_ARRVAL_P(state), i)) == NULL) {
+				break;
+			}
+			out[i] = zval_get_double(zv);
+		}
+		if (i == STATE_FIELDS) {
+			return SUCCESS;
+		}
+	}
+	zephir_throw_exception_format(spl_ce_InvalidArgumentException, "State of entity " ZEND_ULONG_FMT " must be a list of x, y, z, pitch, yaw and head yaw", id);
+	return FAILURE;
+}
+
+/**
+ * A rotation in degrees as sent on the wire, 256 steps per turn; truncated
+ * like (int) in PHP and wrapped to a byte like putByte()
+ */
+static zend_always_inline unsigned char quantize_rotation(double degrees)
+{
+	double steps = degrees / (360.0 / 256.0);
+
+	if (!zend_finite(steps) || steps >= 9.2e18 || steps <= -9.2e18) {
+		return 0;
+	}
+	return (unsigned char) (uint64_t) (int64_t) steps;
+}
+
+/**
+ * Encodes one MoveActorDeltaPacket body into dst and returns its length
+ */
+static size_t encode_delta(unsigned char *dst, zend_ulong id, int flags, const double state[STATE_FIELDS], const unsigned char rotation[3])
+{
+	unsigned char *p = dst;
+	int i;
+
+	p += varint_write_u32(p, MOVEMENT_PACKET_ID);
+	p += varint_write_u64(p, (uint64_t) id);
+	store_le16(p, (uint16_t) flags);
+	p += 2;
+	for (i = 0; i < 3; i++) {
+		if (flags & (MOVEMENT_HAS_X << i)) {
+			binary_fixed_store_float(p, state[i], BINARY_LFLOAT);
+			p += 4;
+		}
+	}
+	for (i = 0; i < 3; i++) {
+		if (flags & (MOVEMENT_HAS_ROT_X << i)) {
+			*p++ = rotation[i];
+		}
+	}
+	return (size_t) (p - dst);
+}
+
+/**
+ * MovementDelta::encode(): compares the current state of every entity with
+ * the previous one and appends a length-prefixed MoveActorDeltaPacket with
+ * the changed fields for each entity that moved. A coordinate changed when it
+ * moved by more than threshold, a rotation when its quantized byte differs.
+ * Entities without a previous state are sent in full. Returns the number of
+ * packets written.
+ */
+int movement_native_encode(zval *return_value, zval *stream, zval *previous, zval *current, zval *threshold_zv)
+{
+	double threshold = zval_get_double(threshold_zv);
+	double now[STATE_FIELDS], before[STATE_FIELDS];
+	unsigned char rotation[3], body[MOVEMENT_MAX_BODY];
+	unsigned char *dst;
+	zend_string *key;
+	zend_ulong id;
+	zend_long packets = 0;
+	zval *state, *old;
+	size_t len;
+	int flags, i;
+
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(current), id, key, state) {
+		if (key != NULL) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Entity runtime IDs must be integers, got \"%s\"", ZSTR_VAL(key));
+			return FAILURE;
+		}
+		if (read_state(state, id, now) == FAILURE) {
+			return FAILURE;
+		}
+		for (i = 0; i < 3; i++) {
+			rotation[i] = quantize_rotation(now[3 + i]);
+		}
+
+		old = zend_hash_index_find(Z_ARRVAL_P(previous), id);
+		if (old == NULL) {
+			flags = MOVEMENT_HAS_ALL;
+		} else {
+			if (read_state(old, id, before) == FAILURE) {
+				return FAILURE;
+			}
+			flags = 0;
+			for (i = 0; i < 3; i++) {
+				if (fabs(now[i] - before[i]) > threshold) {
+					flags |= MOVEMENT_HAS_X << i;
+				}
+				if (rotation[i] != quantize_rotation(before[3 + i])) {
+					flags |= MOVEMENT_HAS_ROT_X << i;
+				}
+			}
+			if (flags == 0) {
+				continue;
+			}
+		}
+
+		len = encode_delta(body, id, flags, now, rotation);
+		dst = (unsigned char *) binarystream_write_ptr(stream, varint_size_u32((uint32_t) len) + len);
+		dst += varint_write_u32(dst, (uint32_t) len);
+		memcpy(dst, body, len);
+		packets++;
+	} ZEND_HASH_FOREACH_END();
+
+	ZVAL_LONG(return_value, packets);
+	return SUCCESS;
+}
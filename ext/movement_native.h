@@ -0,0 +1,20 @@
+#ifndef MOVEMENT_NATIVE_H
+#define MOVEMENT_NATIVE_H
+
+#include <php.h>
+
+/* ID of MoveActorDeltaPacket */
+#define MOVEMENT_PACKET_ID 0x6f
+
+/* Flags of the fields present in a packet, same values as the MovementDelta::FLAG_* constants */
+#define MOVEMENT_HAS_X     0x01
+#define MOVEMENT_HAS_Y     0x02
+#define MOVEMENT_HAS_Z     0x04
+#define MOVEMENT_HAS_ROT_X 0x08 /* pitch */
+#define MOVEMENT_HAS_ROT_Y 0x10 /* yaw */
+#define MOVEMENT_HAS_ROT_Z 0x20 /* head yaw */
+#define MOVEMENT_HAS_ALL   0x3f
+
+int movement_native_encode(zval *return_value, zval *stream, zval *previous, zval *current, zval *threshold);
+
+#endif
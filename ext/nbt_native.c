@@ -0,0 +1,616 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "nbt_native.h"
+
+/*
+ * Tags are represented as [type, value] pairs. The value of a compound is an
+ * array of pairs keyed by name, the value of a list is [element type, values]
+ * where the values are bare, and byte arrays are strings. A root tag is read
+ * and written as a one element array mapping its name to its pair.
+ */
+
+/* Depth limit when writing, which also stops cycles made with references */
+#define NBT_WRITE_MAX_DEPTH 512
+
+typedef struct _nbt_reader {
+	const unsigned char *buf;
+	size_t len;
+	size_t pos;
+	int network;
+	zend_long max_depth;
+	zend_long max_tags;
+	zend_long tags_left;  /* tags that may still be read before max_tags is exceeded */
+} nbt_reader;
+
+static int nbt_eof(nbt_reader *r, size_t need)
+{
+	zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Not enough bytes left in buffer: need %zu, have %zu", need, r->len - r->pos);
+	return FAILURE;
+}
+
+#define NBT_NEED(r, n) do { \
+	if (UNEXPECTED((r)->len - (r)->pos < (n))) { \
+		return nbt_eof(r, n); \
+	} \
+} while (0)
+
+/**
+ * Counts n more tags against the budget, as each one becomes at least one PHP
+ * array however few bytes it takes
+ */
+static int take_tags(nbt_reader *r, size_t n)
+{
+	if (UNEXPECTED(n > (zend_ulong) r->tags_left)) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "NBT has more than the maximum of " ZEND_LONG_FMT " tags", r->max_tags);
+		return FAILURE;
+	}
+	r->tags_left -= (zend_long) n;
+	return SUCCESS;
+}
+
+static int read_varint(nbt_reader *r, uint64_t *out, int is_long)
+{
+	uint32_t value32;
+	int status;
+
+	if (is_long) {
+		status = varint_read_u64(r->buf, r->len, &r->pos, out);
+	} else {
+		status = varint_read_u32(r->buf, r->len, &r->pos, &value32);
+		*out = value32;
+	}
+	if (UNEXPECTED(status != BINARY_OK)) {
+		if (status == BINARY_EOF) {
+			zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("No bytes left in buffer"));
+		} else {
+			zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "%s did not terminate after %d bytes!", is_long ? "VarLong" : "VarInt", is_long ? VARLONG_MAX_BYTES : VARINT_MAX_BYTES);
+		}
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+static int read_int(nbt_reader *r, zend_long *out)
+{
+	uint64_t raw;
+
+	if (r->network) {
+		if (read_varint(r, &raw, 0) == FAILURE) {
+			return FAILURE;
+		}
+		*out = zigzag_decode32((uint32_t) raw);
+		return SUCCESS;
+	}
+	NBT_NEED(r, 4);
+	*out = (zend_long) binary_fixed_load_int(r->buf + r->pos, BINARY_LINT);
+	r->pos += 4;
+	return SUCCESS;
+}
+
+static int read_long(nbt_reader *r, zend_long *out)
+{
+	uint64_t raw;
+
+	if (r->network) {
+		if (read_varint(r, &raw, 1) == FAILURE) {
+			return FAILURE;
+		}
+		*out = (zend_long) zigzag_decode64(raw);
+		return SUCCESS;
+	}
+	NBT_NEED(r, 8);
+	*out = (zend_long) binary_fixed_load_int(r->buf + r->pos, BINARY_LLONG);
+	r->pos += 8;
+	return SUCCESS;
+}
+
+/**
+ * Reads the element count of an array or list, rejecting counts that the
+ * rest of the buffer can't hold at min_size bytes per element before anything
+ * is allocated for them
+ */
+static int read_count(nbt_reader *r, size_t min_size, size_t *count)
+{
+	zend_long n;
+
+	if (read_int(r, &n) == FAILURE) {
+		return FAILURE;
+	}
+	if (n < 0 || (size_t) n > (r->len - r->pos) / min_size) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Invalid NBT length " ZEND_LONG_FMT " with %zu bytes left", n, r->len - r->pos);
+		return FAILURE;
+	}
+	*count = (size_t) n;
+	return SUCCESS;
+}
+
+static int read_string(nbt_reader *r, zend_string **out)
+{
+	uint64_t len;
+
+	if (r->network) {
+		if (read_varint(r, &len, 0) == FAILURE) {
+			return FAILURE;
+		}
+		if (len > NBT_MAX_STRING) {
+			zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "NBT string length %zu exceeds the maximum of %d bytes", (size_t) len, NBT_MAX_STRING);
+			return FAILURE;
+		}
+	} else {
+		NBT_NEED(r, 2);
+		len = (uint64_t) binary_fixed_load_int(r->buf + r->pos, BINARY_LSHORT);
+		r->pos += 2;
+	}
+	NBT_NEED(r, (size_t) len);
+	*out = zend_string_init((const char *) r->buf + r->pos, (size_t) len, 0);
+	r->pos += (size_t) len;
+	return SUCCESS;
+}
+
+static void make_pair(zval *pair, int type, zval *value)
+{
+	array_init_size(pair, 2);
+	add_next_index_long(pair, type);
+	add_next_index_zval(pair, value);
+}
+
+static int read_payload(nbt_reader *r, int type, zval *out, zend_long depth);
+
+static int read_compound(nbt_reader *r, zval *out, zend_long depth)
+{
+	zend_string *name;
+	zval value, pair;
+	int type;
+
+	array_init(out);
+	for (;;) {
+		if (r->pos >= r->len) {
+			nbt_eof(r, 1);
+			goto error;
+		}
+		type = r->buf[r->pos++];
+		if (type == NBT_TAG_END) {
+			return SUCCESS;
+		}
+		if (take_tags(r, 1) == FAILURE || read_string(r, &name) == FAILURE) {
+			goto error;
+		}
+		if (read_payload(r, type, &value, depth) == FAILURE) {
+			zend_string_release(name);
+			goto error;
+		}
+		make_pair(&pair, type, &value);
+		zend_symtable_update(Z_ARRVAL_P(out), name, &pair);
+		zend_string_release(name);
+	}
+
+error:
+	zval_ptr_dtor(out);
+	ZVAL_NULL(out);
+	return FAILURE;
+}
+
+static int read_list(nbt_reader *r, zval *out, zend_long depth)
+{
+	size_t count, i;
+	zval values, value;
+	int type;
+
+	NBT_NEED(r, 1);
+	type = r->buf[r->pos++];
+	if (type > NBT_TAG_LONG_ARRAY) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Unknown NBT tag type %d", type);
+		return FAILURE;
+	}
+	if (read_count(r, 1, &count) == FAILURE) {
+		return FAILURE;
+	}
+	if (count > 0 && type == NBT_TAG_END) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("NBT list of TAG_End cannot have entries"));
+		return FAILURE;
+	}
+	if (take_tags(r, count) == FAILURE) {
+		return FAILURE;
+	}
+	array_init_size(&values, (uint32_t) count);
+	for (i = 0; i < count; i++) {
+		if (read_payload(r, type, &value, depth) == FAILURE) {
+			zval_ptr_dtor(&values);
+			return FAILURE;
+		}
+		zend_hash_next_index_insert_new(Z_ARRVAL(values), &value);
+	}
+	make_pair(out, type, &values);
+	return SUCCESS;
+}
+
+static int read_payload(nbt_reader *r, int type, zval *out, zend_long depth)
+{
+	size_t count, i;
+	zend_long n;
+	zend_string *str;
+
+	switch (type) {
+		case NBT_TAG_BYTE:
+			NBT_NEED(r, 1);
+			ZVAL_LONG(out, (signed char) r->buf[r->pos++]);
+			return SUCCESS;
+		case NBT_TAG_SHORT:
+			NBT_NEED(r, 2);
+			ZVAL_LONG(out, (zend_long) binary_fixed_load_int(r->buf + r->pos, BINARY_SIGNED_LSHORT));
+			r->pos += 2;
+			return SUCCESS;
+		case NBT_TAG_INT:
+			if (read_int(r, &n) == FAILURE) {
+				return FAILURE;
+			}
+			ZVAL_LONG(out, n);
+			return SUCCESS;
+		case NBT_TAG_LONG:
+			if (read_long(r, &n) == FAILURE) {
+				return FAILURE;
+			}
+			ZVAL_LONG(out, n);
+			return SUCCESS;
+		case NBT_TAG_FLOAT:
+			NBT_NEED(r, 4);
+			ZVAL_DOUBLE(out, binary_fixed_load_float(r->buf + r->pos, BINARY_LFLOAT));
+			r->pos += 4;
+			return SUCCESS;
+		case NBT_TAG_DOUBLE:
+			NBT_NEED(r, 8);
+			ZVAL_DOUBLE(out, binary_fixed_load_float(r->buf + r->pos, BINARY_LDOUBLE));
+			r->pos += 8;
+			return SUCCESS;
+		case NBT_TAG_BYTE_ARRAY:
+			if (read_count(r, 1, &count) == FAILURE) {
+				return FAILURE;
+			}
+			ZVAL_STRINGL(out, (const char *) r->buf + r->pos, count);
+			r->pos += count;
+			return SUCCESS;
+		case NBT_TAG_STRING:
+			if (read_string(r, &str) == FAILURE) {
+				return FAILURE;
+			}
+			ZVAL_STR(out, str);
+			return SUCCESS;
+		case NBT_TAG_LIST:
+		case NBT_TAG_COMPOUND:
+			if (depth >= r->max_depth) {
+				zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "NBT is nested deeper than the maximum of " ZEND_LONG_FMT " levels", r->max_depth);
+				return FAILURE;
+			}
+			return type == NBT_TAG_LIST ? read_list(r, out, depth + 1) : read_compound(r, out, depth + 1);
+		case NBT_TAG_INT_ARRAY:
+		case NBT_TAG_LONG_ARRAY:
+			if (read_count(r, r->network ? 1 : (type == NBT_TAG_INT_ARRAY ? 4 : 8), &count) == FAILURE) {
+				return FAILURE;
+			}
+			array_init_size(out, (uint32_t) count);
+			for (i = 0; i < count; i++) {
+				if ((type == NBT_TAG_INT_ARRAY ? read_int(r, &n) : read_long(r, &n)) == FAILURE) {
+					zval_ptr_dtor(out);
+					ZVAL_NULL(out);
+					return FAILURE;
+				}
+				add_next_index_long(out, n);
+			}
+			return SUCCESS;
+		default:
+			zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Unknown NBT tag type %d", type);
+			return FAILURE;
+	}
+}
+
+static int check_flavour(zend_long flavour)
+{
+	if (flavour != NBT_NETWORK && flavour != NBT_LITTLE_ENDIAN) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown NBT flavour " ZEND_LONG_FMT, flavour);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+/**
+ * Nbt::read(stream, flavour, maxDepth, maxTags): decodes the root tag at the
+ * stream offset; nothing is consumed when the data is malformed
+ */
+int nbt_native_read(zval *return_value, zval *stream, zval *flavour_zv, zval *max_depth, zval *max_tags)
+{
+	nbt_reader r;
+	zend_long offset, flavour = zval_get_long(flavour_zv);
+	zend_string *name;
+	zval value, pair;
+	int type;
+
+	if (check_flavour(flavour) == FAILURE) {
+		return FAILURE;
+	}
+	r.max_depth = zval_get_long(max_depth);
+	if (r.max_depth < 1) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum depth must be positive"));
+		return FAILURE;
+	}
+	r.max_tags = zval_get_long(max_tags);
+	if (r.max_tags < 1) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum tag count must be positive"));
+		return FAILURE;
+	}
+	/* the root tag is the first one */
+	r.tags_left = r.max_tags - 1;
+	r.network = flavour == NBT_NETWORK;
+	r.buf = (const unsigned char *) binarystream_cursor(stream, &r.len, &offset);
+	if (offset < 0 || (size_t) offset >= r.len) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("No bytes left in buffer"));
+		return FAILURE;
+	}
+	r.pos = (size_t) offset;
+
+	type = r.buf[r.pos++];
+	if (type == NBT_TAG_END) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("Found TAG_End where a root tag was expected"));
+		return FAILURE;
+	}
+	if (read_string(&r, &name) == FAILURE) {
+		return FAILURE;
+	}
+	if (read_payload(&r, type, &value, 0) == FAILURE) {
+		zend_string_release(name);
+		return FAILURE;
+	}
+	make_pair(&pair, type, &value);
+	array_init_size(return_value, 1);
+	zend_symtable_update(Z_ARRVAL_P(return_value), name, &pair);
+	zend_string_release(name);
+
+	binarystream_seek(stream, (zend_long) r.pos);
+	return SUCCESS;
+}
+
+typedef struct _nbt_writer {
+	zval *stream;
+	int network;
+} nbt_writer;
+
+static void write_int(nbt_writer *w, zend_long v)
+{
+	if (w->network) {
+		binarystream_write_varint(w->stream, zigzag_encode32((int32_t) v));
+	} else {
+		binary_fixed_store_int((unsigned char *) binarystream_write_ptr(w->stream, 4), v, BINARY_LINT);
+	}
+}
+
+static void write_long(nbt_writer *w, zend_long v)
+{
+	if (w->network) {
+		binarystream_write_varint(w->stream, zigzag_encode64((int64_t) v));
+	} else {
+		binary_fixed_store_int((unsigned char *) binarystream_write_ptr(w->stream, 8), v, BINARY_LLONG);
+	}
+}
+
+static int write_count(nbt_writer *w, size_t count)
+{
+	if (count > INT32_MAX) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "%zu elements are too many for NBT", count);
+		return FAILURE;
+	}
+	write_int(w, (zend_long) count);
+	return SUCCESS;
+}
+
+static int write_string(nbt_writer *w, const char *str, size_t len)
+{
+	if (len > NBT_MAX_STRING) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "NBT string of %zu bytes exceeds the maximum of %d bytes", len, NBT_MAX_STRING);
+		return FAILURE;
+	}
+	if (w->network) {
+		binarystream_write_varint(w->stream, (uint32_t) len);
+	} else {
+		binary_fixed_store_int((unsigned char *) binarystream_write_ptr(w->stream, 2), (int64_t) len, BINARY_LSHORT);
+	}
+	if (len) {
+		memcpy(binarystream_write_ptr(w->stream, len), str, len);
+	}
+	return SUCCESS;
+}
+
+/**
+ * Splits a [type, value] pair
+ */
+static int tag_pair(zval *pair, int *type, zval **value)
+{
+	zval *type_zv;
+
+	ZVAL_DEREF(pair);
+	if (Z_TYPE_P(pair) != IS_ARRAY
+		|| (type_zv = zend_hash_index_find(Z_ARRVAL_P(pair), 0)) == NULL
+		|| (*value = zend_hash_index_find(Z_ARRVAL_P(pair), 1)) == NULL
+	) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("NBT tags must be [type, value] pairs"));
+		return FAILURE;
+	}
+	*type = (int) zval_get_long(type_zv);
+	return SUCCESS;
+}
+
+static int expect_array(zval *value, int type)
+{
+	if (Z_TYPE_P(value) != IS_ARRAY) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Value of NBT tag type %d must be an array", type);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+static int write_payload(nbt_writer *w, int type, zval *value, int depth);
+
+static int write_named(nbt_writer *w, zend_string *key, zend_ulong index, zval *pair, int depth)
+{
+	char digits[MAX_LENGTH_OF_LONG + 1], *end = digits + sizeof(digits) - 1, *start;
+	zval *value;
+	int type, status;
+
+	if (tag_pair(pair, &type, &value) == FAILURE) {
+		return FAILURE;
+	}
+	if (type == NBT_TAG_END) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Named NBT tags cannot be TAG_End"));
+		return FAILURE;
+	}
+	*binarystream_write_ptr(w->stream, 1) = (char) type;
+	if (key) {
+		status = write_string(w, ZSTR_VAL(key), ZSTR_LEN(key));
+	} else {
+		*end = '\0';
+		start = zend_print_long_to_buf(end, (zend_long) index);
+		status = write_string(w, start, (size_t) (end - start));
+	}
+	if (status == FAILURE) {
+		return FAILURE;
+	}
+	return write_payload(w, type, value, depth);
+}
+
+static int write_payload(nbt_writer *w, int type, zval *value, int depth)
+{
+	zend_string *key, *str;
+	zend_ulong index;
+	zval *entry, *values;
+	int element, status;
+
+	ZVAL_DEREF(value);
+	switch (type) {
+		case NBT_TAG_BYTE:
+			*binarystream_write_ptr(w->stream, 1) = (char) zval_get_long(value);
+			return SUCCESS;
+		case NBT_TAG_SHORT:
+			binary_fixed_store_int((unsigned char *) binarystream_write_ptr(w->stream, 2), zval_get_long(value), BINARY_LSHORT);
+			return SUCCESS;
+		case NBT_TAG_INT:
+			write_int(w, zval_get_long(value));
+			return SUCCESS;
+		case NBT_TAG_LONG:
+			write_long(w, zval_get_long(value));
+			return SUCCESS;
+		case NBT_TAG_FLOAT:
+			binary_fixed_store_float((unsigned char *) binarystream_write_ptr(w->stream, 4), zval_get_double(value), BINARY_LFLOAT);
+			return SUCCESS;
+		case NBT_TAG_DOUBLE:
+			binary_fixed_store_float((unsigned char *) binarystream_write_ptr(w->stream, 8), zval_get_double(value), BINARY_LDOUBLE);
+			return SUCCESS;
+		case NBT_TAG_BYTE_ARRAY:
+		case NBT_TAG_STRING:
+			str = zval_get_string(value);
+			if (type == NBT_TAG_STRING) {
+				status = write_string(w, ZSTR_VAL(str), ZSTR_LEN(str));
+			} else if ((status = write_count(w, ZSTR_LEN(str))) == SUCCESS && ZSTR_LEN(str)) {
+				memcpy(binarystream_write_ptr(w->stream, ZSTR_LEN(str)), ZSTR_VAL(str), ZSTR_LEN(str));
+			}
+			zend_string_release(str);
+			return status;
+		case NBT_TAG_LIST:
+		case NBT_TAG_COMPOUND:
+			if (depth >= NBT_WRITE_MAX_DEPTH) {
+				zephir_throw_exception_format(spl_ce_InvalidArgumentException, "NBT is nested deeper than the maximum of %d levels", NBT_WRITE_MAX_DEPTH);
+				return FAILURE;
+			}
+			if (expect_array(value, type) == FAILURE) {
+				return FAILURE;
+			}
+			if (type == NBT_TAG_COMPOUND) {
+				ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(value), index, key, entry) {
+					if (write_named(w, key, index, entry, depth + 1) == FAILURE) {
+						return FAILURE;
+					}
+				} ZEND_HASH_FOREACH_END();
+				*binarystream_write_ptr(w->stream, 1) = NBT_TAG_END;
+				return SUCCESS;
+			}
+			if (tag_pair(value, &element, &values) == FAILURE) {
+				return FAILURE;
+			}
+			ZVAL_DEREF(values);
+			if (expect_array(values, type) == FAILURE) {
+				return FAILURE;
+			}
+			if (element < NBT_TAG_END || element > NBT_TAG_LONG_ARRAY
+				|| (element == NBT_TAG_END && zend_hash_num_elements(Z_ARRVAL_P(values)) > 0)) {
+				zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Invalid NBT list element type %d", element);
+				return FAILURE;
+			}
+			*binarystream_write_ptr(w->stream, 1) = (char) element;
+			if (write_count(w, zend_hash_num_elements(Z_ARRVAL_P(values))) == FAILURE) {
+				return FAILURE;
+			}
+			ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(values), entry) {
+				if (write_payload(w, element, entry, depth + 1) == FAILURE) {
+					return FAILURE;
+				}
+			} ZEND_HASH_FOREACH_END();
+			return SUCCESS;
+		case NBT_TAG_INT_ARRAY:
+		case NBT_TAG_LONG_ARRAY:
+			if (expect_array(value, type) == FAILURE || write_count(w, zend_hash_num_elements(Z_ARRVAL_P(value))) == FAILURE) {
+				return FAILURE;
+			}
+			ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(value), entry) {
+				if (type == NBT_TAG_INT_ARRAY) {
+					write_int(w, zval_get_long(entry));
+				} else {
+					write_long(w, zval_get_long(entry));
+				}
+			} ZEND_HASH_FOREACH_END();
+			return SUCCESS;
+		default:
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown NBT tag type %d", type);
+			return FAILURE;
+	}
+}
+
+/**
+ * Nbt::write(stream, root, flavour): appends a root tag given as
+ * [name => [type, value]]; nothing is written when part of it is invalid
+ */
+int nbt_native_write(zval *return_value, zval *stream, zval *root, zval *flavour_zv)
+{
+	nbt_writer w;
+	zend_long flavour = zval_get_long(flavour_zv);
+	zend_string *key;
+	zend_ulong index;
+	zval *pair;
+	size_t start;
+
+	if (check_flavour(flavour) == FAILURE) {
+		return FAILURE;
+	}
+	if (Z_TYPE_P(root) != IS_ARRAY || zend_hash_num_elements(Z_ARRVAL_P(root)) != 1) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("The root must be an array with exactly one named tag"));
+		return FAILURE;
+	}
+	w.stream = stream;
+	w.network = flavour == NBT_NETWORK;
+	start = binarystream_length(stream);
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(root), index, key, pair) {
+		if (write_named(&w, key, index, pair, 0) == FAILURE) {
+			binarystream_truncate(stream, start);
+			return FAILURE;
+		}
+	} ZEND_HASH_FOREACH_END();
+	return SUCCESS;
+}
@@ -0,0 +1,31 @@
+#ifndef NBT_NATIVE_H
+#define NBT_NATIVE_H
+
+#include <php.h>
+
+/* Tag types, same values as the Nbt::TAG_* constants */
+#define NBT_TAG_END         0
+#define NBT_TAG_BYTE        1
+#define NBT_TAG_SHORT       2
+#define NBT_TAG_INT         3
+#define NBT_TAG_LONG        4
+#define NBT_TAG_FLOAT       5
+#define NBT_TAG_DOUBLE      6
+#define NBT_TAG_BYTE_ARRAY  7
+#define NBT_TAG_STRING      8
+#define NBT_TAG_LIST        9
+#define NBT_TAG_COMPOUND   10
+#define NBT_TAG_INT_ARRAY  11
+#define NBT_TAG_LONG_ARRAY 12
+
+/* Encodings, same values as the Nbt flavour constants */
+#define NBT_NETWORK       0 /* little-endian with var-int ints, longs and lengths */
+#define NBT_LITTLE_ENDIAN 1 /* little-endian fixed-width, as stored on disk */
+
+/* Longest string NBT can hold, in bytes */
+#define NBT_MAX_STRING 32767
+
+int nbt_native_read(zval *return_value, zval *stream, zval *flavour, zval *max_depth, zval *max_tags);
+int nbt_native_write(zval *return_value, zval *stream, zval *root, zval *flavour);
+
+#endif
@@ -0,0 +1,464 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "vector3_native.h"
+#include "packetschema_native.h"
+
+typedef enum _schema_op {
+	SCHEMA_BOOL,
+	SCHEMA_BYTE,
+	SCHEMA_FIXED,
+	SCHEMA_UNSIGNED_VARINT,
+	SCHEMA_VARINT,
+	SCHEMA_UNSIGNED_VARLONG,
+	SCHEMA_VARLONG,
+	SCHEMA_STRING,
+	SCHEMA_VECTOR3
+} schema_op;
+
+typedef struct _schema_type {
+	const char *name;
+	unsigned char op;
+	unsigned char fixed;
+} schema_type;
+
+/* Field types, named after the BinaryStream methods reading them */
+static const schema_type schema_types[] = {
+	{"bool",             SCHEMA_BOOL,             0},
+	{"byte",             SCHEMA_BYTE,             0},
+	{"short",            SCHEMA_FIXED,            BINARY_SHORT},
+	{"signed_short",     SCHEMA_FIXED,            BINARY_SIGNED_SHORT},
+	{"lshort",           SCHEMA_FIXED,            BINARY_LSHORT},
+	{"signed_lshort",    SCHEMA_FIXED,            BINARY_SIGNED_LSHORT},
+	{"triad",            SCHEMA_FIXED,            BINARY_TRIAD},
+	{"ltriad",           SCHEMA_FIXED,            BINARY_LTRIAD},
+	{"int",              SCHEMA_FIXED,            BINARY_INT},
+	{"lint",             SCHEMA_FIXED,            BINARY_LINT},
+	{"long",             SCHEMA_FIXED,            BINARY_LONG},
+	{"llong",            SCHEMA_FIXED,            BINARY_LLONG},
+	{"float",            SCHEMA_FIXED,            BINARY_FLOAT},
+	{"lfloat",           SCHEMA_FIXED,            BINARY_LFLOAT},
+	{"double",           SCHEMA_FIXED,            BINARY_DOUBLE},
+	{"ldouble",          SCHEMA_FIXED,            BINARY_LDOUBLE},
+	{"unsigned_varint",  SCHEMA_UNSIGNED_VARINT,  0},
+	{"varint",           SCHEMA_VARINT,           0},
+	{"unsigned_varlong", SCHEMA_UNSIGNED_VARLONG, 0},
+	{"varlong",          SCHEMA_VARLONG,          0},
+	{"string",           SCHEMA_STRING,           0},
+	{"vector3",          SCHEMA_VECTOR3,          0},
+	{NULL,               0,                       0}
+};
+
+static zend_object_handlers packetschema_handlers;
+
+static void packetschema_release(packetschema_object *intern)
+{
+	uint32_t i;
+
+	for (i = 0; i < intern->count; i++) {
+		zend_string_release(intern->fields[i].name);
+	}
+	if (intern->fields) {
+		efree(intern->fields);
+	}
+	if (intern->bound) {
+		efree(intern->bound);
+	}
+	intern->fields = NULL;
+	intern->bound = NULL;
+	intern->bound_ce = NULL;
+	intern->count = 0;
+}
+
+static zend_object *packetschema_create_object(zend_class_entry *ce)
+{
+	packetschema_object *intern = zend_object_alloc(sizeof(packetschema_object), ce);
+
+	memset(intern, 0, XtOffsetOf(packetschema_object, std));
+	zend_object_std_init(&intern->std, ce);
+	object_properties_init(&intern->std, ce);
+	intern->std.handlers = &packetschema_handlers;
+
+	return &intern->std;
+}
+
+static void packetschema_free_object(zend_object *obj)
+{
+	packetschema_release(packetschema_fetch(obj));
+	zend_object_std_dtor(obj);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zend_object *packetschema_clone_object(zend_object *old_obj)
+{
+#else
+static zend_object *packetschema_clone_object(zval *object)
+{
+	zend_object *old_obj = Z_OBJ_P(object);
+#endif
+	zend_object *new_obj = packetschema_create_object(old_obj->ce);
+	packetschema_object *old_intern = packetschema_fetch(old_obj);
+	packetschema_object *new_intern = packetschema_fetch(new_obj);
+	uint32_t i;
+
+	zend_objects_clone_members(new_obj, old_obj);
+	if (old_intern->count) {
+		new_intern->fields = safe_emalloc(old_intern->count, sizeof(packetschema_field), 0);
+		for (i = 0; i < old_intern->count; i++) {
+			new_intern->fields[i] = old_intern->fields[i];
+			zend_string_addref(new_intern->fields[i].name);
+		}
+		new_intern->count = old_intern->count;
+	}
+
+	return new_obj;
+}
+
+void packetschema_module_init(void)
+{
+	pocketmine_utils_packetschema_ce->create_object = packetschema_create_object;
+	memcpy(&packetschema_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	packetschema_handlers.offset = XtOffsetOf(packetschema_object, std);
+	packetschema_handlers.free_obj = packetschema_free_object;
+	packetschema_handlers.clone_obj = packetschema_clone_object;
+}
+
+/**
+ * Turns the field name => type array into the op program of the schema
+ */
+int packetschema_compile(zval *return_value, zval *schema, zval *fields)
+{
+	packetschema_object *intern = packetschema_fetch(Z_OBJ_P(schema));
+	packetschema_field *program;
+	const schema_type *type;
+	zend_string *name;
+	zend_ulong index;
+	uint32_t count = 0;
+	zval *value;
+
+	if (Z_TYPE_P(fields) != IS_ARRAY) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Fields must be an array"));
+		return FAILURE;
+	}
+	program = safe_emalloc(zend_hash_num_elements(Z_ARRVAL_P(fields)) + 1, sizeof(packetschema_field), 0);
+
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(fields), index, name, value) {
+		if (name == NULL) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Field name must be a string, got " ZEND_ULONG_FMT, index);
+			goto error;
+		}
+		ZVAL_DEREF(value);
+		if (Z_TYPE_P(value) != IS_STRING) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Type of field \"%s\" must be a string", ZSTR_VAL(name));
+			goto error;
+		}
+		for (type = schema_types; type->name != NULL; type++) {
+			if (strcmp(type->name, Z_STRVAL_P(value)) == 0) {
+				break;
+			}
+		}
+		if (type->name == NULL) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown type \"%s\" of field \"%s\"", Z_STRVAL_P(value), ZSTR_VAL(name));
+			goto error;
+		}
+		program[count].name = zend_string_copy(name);
+		program[count].op = type->op;
+		program[count].fixed = type->fixed;
+		count++;
+	} ZEND_HASH_FOREACH_END();
+
+	packetschema_release(intern);
+	intern->fields = program;
+	intern->count = count;
+	return SUCCESS;
+
+error:
+	while (count > 0) {
+		zend_string_release(program[--count].name);
+	}
+	efree(program);
+	return FAILURE;
+}
+
+/**
+ * Looks up the declared property of each field in the class of obj; the
+ * result is kept for the next object of the same class
+ */
+static zend_property_info **bind_class(packetschema_object *intern, zend_class_entry *ce)
+{
+	zend_property_info *info;
+	uint32_t i;
+
+	if (intern->bound_ce == ce) {
+		return intern->bound;
+	}
+	if (intern->bound == NULL) {
+		intern->bound = safe_emalloc(intern->count + 1, sizeof(zend_property_info *), 0);
+	}
+	for (i = 0; i < intern->count; i++) {
+		info = zend_hash_find_ptr(&ce->properties_info, intern->fields[i].name);
+		intern->bound[i] = info != NULL && !(info->flags & ZEND_ACC_STATIC) ? info : NULL;
+	}
+	intern->bound_ce = ce;
+	return intern->bound;
+}
+
+/**
+ * Moves value into the field property of obj. Untyped declared properties
+ * are written straight into their slot; typed and undeclared ones go through
+ * the engine so types are checked and coerced.
+ */
+static void hydrate(zval *object, zend_property_info *info, zend_string *name, zval *value)
+{
+	zval *slot;
+
+#if PHP_VERSION_ID >= 70400
+	if (info != NULL && !ZEND_TYPE_IS_SET(info->type)) {
+#else
+	if (info != NULL) {
+#endif
+		slot = OBJ_PROP(Z_OBJ_P(object), info->offset);
+		ZVAL_DEREF(slot);
+		zval_ptr_dtor(slot);
+		ZVAL_COPY_VALUE(slot, value);
+		return;
+	}
+#if PHP_VERSION_ID >= 80000
+	zend_update_property_ex(info ? info->ce : Z_OBJCE_P(object), Z_OBJ_P(object), name, value);
+#else
+	zend_update_property_ex(info ? info->ce : Z_OBJCE_P(object), object, name, value);
+#endif
+	zval_ptr_dtor(value);
+}
+
+static int decode_field(zval *result, const packetschema_field *field, zval *stream)
+{
+	const char *ptr;
+	double v[3];
+	zval no_limit;
+	int i;
+
+	switch (field->op) {
+		case SCHEMA_BOOL:
+			if ((ptr = binarystream_read_ptr(stream, 1)) == NULL) {
+				return FAILURE;
+			}
+			ZVAL_BOOL(result, *ptr != '\0');
+			return SUCCESS;
+		case SCHEMA_BYTE:
+			if ((ptr = binarystream_read_ptr(stream, 1)) == NULL) {
+				return FAILURE;
+			}
+			ZVAL_LONG(result, (unsigned char) *ptr);
+			return SUCCESS;
+		case SCHEMA_FIXED:
+			return binarystream_get_fixed(result, stream, field->fixed);
+		case SCHEMA_UNSIGNED_VARINT:
+			return binarystream_get_unsigned_varint(result, stream);
+		case SCHEMA_VARINT:
+			return binarystream_get_varint(result, stream);
+		case SCHEMA_UNSIGNED_VARLONG:
+			return binarystream_get_unsigned_varlong(result, stream);
+		case SCHEMA_VARLONG:
+			return binarystream_get_varlong(result, stream);
+		case SCHEMA_STRING:
+			ZVAL_LONG(&no_limit, -1);
+			return binarystream_get_string(result, stream, &no_limit);
+		case SCHEMA_VECTOR3:
+			if ((ptr = binarystream_read_ptr(stream, 12)) == NULL) {
+				return FAILURE;
+			}
+			for (i = 0; i < 3; i++) {
+				v[i] = binary_fixed_load_float((const unsigned char *) ptr + i * 4, BINARY_LFLOAT);
+			}
+			vector3_init(result, v[0], v[1], v[2]);
+			return SUCCESS;
+	}
+	return FAILURE;
+}
+
+/**
+ * Decodes every field into a new array, or into the properties of target
+ * when an object is given; target is then returned. Fields decoded before a
+ * failure are left assigned on target.
+ */
+int packetschema_decode(zval *return_value, zval *schema, zval *stream, zval *target)
+{
+	packetschema_object *intern = packetschema_fetch(Z_OBJ_P(schema));
+	zval value;
+	uint32_t i;
+
+	if (Z_TYPE_P(target) == IS_OBJECT) {
+		for (i = 0; i < intern->count; i++) {
+			if (decode_field(&value, &intern->fields[i], stream) == FAILURE) {
+				return FAILURE;
+			}
+			/* bound again per field: a __set() hook may have used this schema on another class */
+			hydrate(target, bind_class(intern, Z_OBJCE_P(target))[i], intern->fields[i].name, &value);
+		}
+		ZVAL_COPY(return_value, target);
+		return SUCCESS;
+	}
+	if (Z_TYPE_P(target) != IS_NULL) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Target must be an object or null"));
+		return FAILURE;
+	}
+
+	array_init_size(return_value, intern->count);
+	for (i = 0; i < intern->count; i++) {
+		if (decode_field(&value, &intern->fields[i], stream) == FAILURE) {
+			zval_ptr_dtor(return_value);
+			ZVAL_NULL(return_value);
+			return FAILURE;
+		}
+		zend_hash_add_new(Z_ARRVAL_P(return_value), intern->fields[i].name, &value);
+	}
+	return SUCCESS;
+}
+
+int packetschema_encode_field(zval *value, const packetschema_field *field, zval *stream)
+{
+	unsigned char *dst;
+	double v[3];
+	zend_long n;
+	int i;
+
+	ZVAL_DEREF(value);
+	switch (field->op) {
+		case SCHEMA_BOOL:
+			*binarystream_write_ptr(stream, 1) = zend_is_true(value) ? 1 : 0;
+			return SUCCESS;
+		case SCHEMA_BYTE:
+			*binarystream_write_ptr(stream, 1) = (char) zval_get_long(value);
+			return SUCCESS;
+		case SCHEMA_FIXED:
+			return binarystream_put_fixed(NULL, stream, value, field->fixed);
+		case SCHEMA_UNSIGNED_VARINT:
+			binarystream_write_varint(stream, (uint32_t) zval_get_long(value));
+			return SUCCESS;
+		case SCHEMA_VARINT:
+			binarystream_write_varint(stream, zigzag_encode32((int32_t) zval_get_long(value)));
+			return SUCCESS;
+		case SCHEMA_UNSIGNED_VARLONG:
+			binarystream_write_varint(stream, (uint64_t) zval_get_long(value));
+			return SUCCESS;
+		case SCHEMA_VARLONG:
+			n = zval_get_long(value);
+			binarystream_write_varint(stream, zigzag_encode64(n));
+			return SUCCESS;
+		case SCHEMA_STRING:
+			return binarystream_put_string(NULL, stream, value);
+		case SCHEMA_VECTOR3:
+			if (vector3_components(value, &v[0], &v[1], &v[2]) == FAILURE) {
+				return FAILURE;
+			}
+			dst = (unsigned char *) binarystream_write_ptr(stream, 12);
+			for (i = 0; i < 3; i++) {
+				binary_fixed_store_float(dst + i * 4, v[i], BINARY_LFLOAT);
+			}
+			return SUCCESS;
+	}
+	return FAILURE;
+}
+
+/**
+ * Encodes every field from an array keyed by field name, or from the
+ * properties of an object; nothing is written when one of them fails
+ */
+int packetschema_encode(zval *return_value, zval *schema, zval *stream, zval *values)
+{
+	return packetschema_encode_marked(schema, stream, values, NULL);
+}
+
+/* Stores the length of the stream before field i when marks are wanted */
+#define MARK(marks, i, stream) do { \
+	if ((marks) != NULL) { \
+		(marks)[i] = binarystream_length(stream); \
+	} \
+} while (0)
+
+static int encode_fields(zval *schema, zval *stream, zval *values, size_t *marks)
+{
+	packetschema_object *intern = packetschema_fetch(Z_OBJ_P(schema));
+	zend_property_info **bound;
+	zval *value, rv;
+	uint32_t i;
+	int status;
+
+	if (Z_TYPE_P(values) == IS_ARRAY) {
+		for (i = 0; i < intern->count; i++) {
+			value = zend_hash_find(Z_ARRVAL_P(values), intern->fields[i].name);
+			if (value == NULL) {
+				zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Missing field \"%s\"", ZSTR_VAL(intern->fields[i].name));
+				return FAILURE;
+			}
+			MARK(marks, i, stream);
+			if (packetschema_encode_field(value, &intern->fields[i], stream) == FAILURE) {
+				return FAILURE;
+			}
+		}
+		MARK(marks, intern->count, stream);
+		return SUCCESS;
+	}
+	if (Z_TYPE_P(values) != IS_OBJECT) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Values must be an array or an object"));
+		return FAILURE;
+	}
+
+	for (i = 0; i < intern->count; i++) {
+		bound = bind_class(intern, Z_OBJCE_P(values));
+		if (bound[i] != NULL) {
+			value = OBJ_PROP(Z_OBJ_P(values), bound[i]->offset);
+			if (Z_ISUNDEF_P(value)) {
+				zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Missing field \"%s\"", ZSTR_VAL(intern->fields[i].name));
+				return FAILURE;
+			}
+			MARK(marks, i, stream);
+			status = packetschema_encode_field(value, &intern->fields[i], stream);
+		} else {
+#if PHP_VERSION_ID >= 80000
+			value = zend_read_property_ex(Z_OBJCE_P(values), Z_OBJ_P(values), intern->fields[i].name, 0, &rv);
+#else
+			value = zend_read_property_ex(Z_OBJCE_P(values), values, intern->fields[i].name, 0, &rv);
+#endif
+			if (EG(exception)) {
+				return FAILURE;
+			}
+			MARK(marks, i, stream);
+			status = packetschema_encode_field(value, &intern->fields[i], stream);
+			if (value == &rv) {
+				zval_ptr_dtor(&rv);
+			}
+		}
+		if (status == FAILURE) {
+			return FAILURE;
+		}
+	}
+	MARK(marks, intern->count, stream);
+	return SUCCESS;
+}
+
+/**
+ * Nothing is left in the stream when a field is missing or can't be encoded
+ */
+int packetschema_encode_marked(zval *schema, zval *stream, zval *values, size_t *marks)
+{
+	size_t start = binarystream_length(stream);
+
+	if (encode_fields(schema, stream, values, marks) == FAILURE) {
+		binarystream_truncate(stream, start);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,39 @@
+#ifndef PACKETSCHEMA_NATIVE_H
+#define PACKETSCHEMA_NATIVE_H
+
+#include <php.h>
+
+/* One step of a compiled schema */
+typedef struct _packetschema_field {
+	zend_string *name;
+	unsigned char op;    /* schema_op */
+	unsigned char fixed; /* binary_fixed_type of SCHEMA_FIXED fields */
+} packetschema_field;
+
+/**
+ * Native part of Pocketmine\Utils\PacketSchema objects
+ */
+typedef struct _packetschema_object {
+	packetschema_field *fields;
+	uint32_t count;
+	zend_class_entry *bound_ce;     /* class the properties below were looked up in */
+	zend_property_info **bound;     /* declared property of each field in bound_ce, or NULL */
+	zend_object std;
+} packetschema_object;
+
+static zend_always_inline packetschema_object *packetschema_fetch(zend_object *obj)
+{
+	return (packetschema_object *) ((char *) obj - XtOffsetOf(packetschema_object, std));
+}
+
+void packetschema_module_init(void);
+
+int packetschema_compile(zval *return_value, zval *schema, zval *fields);
+int packetschema_decode(zval *return_value, zval *schema, zval *stream, zval *target);
+int packetschema_encode(zval *return_value, zval *schema, zval *stream, zval *values);
+/* Like packetschema_encode(), storing in marks[i] the stream length before field i and in marks[count] the final one */
+int packetschema_encode_marked(zval *schema, zval *stream, zval *values, size_t *marks);
+/* Appends one field */
+int packetschema_encode_field(zval *value, const packetschema_field *field, zval *stream);
+
+#endif
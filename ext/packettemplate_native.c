@@ -0,0 +1,361 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include "binary_native.h"
+#include "binarystream_native.h"
+#include "packetschema_native.h"
+#include "packettemplate_native.h"
+
+static zend_object_handlers packettemplate_handlers;
+
+static zend_always_inline packettemplate_object *packettemplate_fetch(zend_object *obj)
+{
+	return (packettemplate_object *) ((char *) obj - XtOffsetOf(packettemplate_object, std));
+}
+
+static void packettemplate_release(packettemplate_object *intern)
+{
+	uint32_t i;
+
+	for (i = 0; i < intern->count; i++) {
+		zend_string_release(intern->patches[i].field.name);
+	}
+	if (intern->patches) {
+		efree(intern->patches);
+	}
+	if (intern->bytes) {
+		zend_string_release(intern->bytes);
+	}
+	intern->patches = NULL;
+	intern->bytes = NULL;
+	intern->count = 0;
+}
+
+static zend_object *packettemplate_create_object(zend_class_entry *ce)
+{
+	packettemplate_object *intern = zend_object_alloc(sizeof(packettemplate_object), ce);
+
+	memset(intern, 0, XtOffsetOf(packettemplate_object, std));
+	zend_object_std_init(&intern->std, ce);
+	object_properties_init(&intern->std, ce);
+	intern->std.handlers = &packettemplate_handlers;
+
+	return &intern->std;
+}
+
+static void packettemplate_free_object(zend_object *obj)
+{
+	packettemplate_release(packettemplate_fetch(obj));
+	zend_object_std_dtor(obj);
+}
+
+#if PHP_VERSION_ID >= 80000
+static zend_object *packettemplate_clone_object(zend_object *old_obj)
+{
+#else
+static zend_object *packettemplate_clone_object(zval *object)
+{
+	zend_object *old_obj = Z_OBJ_P(object);
+#endif
+	zend_object *new_obj = packettemplate_create_object(old_obj->ce);
+	packettemplate_object *old_intern = packettemplate_fetch(old_obj);
+	packettemplate_object *new_intern = packettemplate_fetch(new_obj);
+	uint32_t i;
+
+	/* templates never change once compiled, the clone shares the encoded bytes */
+	zend_objects_clone_members(new_obj, old_obj);
+	if (old_intern->bytes) {
+		new_intern->bytes = zend_string_copy(old_intern->bytes);
+	}
+	if (old_intern->count) {
+		new_intern->patches = safe_emalloc(old_intern->count, sizeof(packettemplate_patch), 0);
+		for (i = 0; i < old_intern->count; i++) {
+			new_intern->patches[i] = old_intern->patches[i];
+			zend_string_addref(new_intern->patches[i].field.name);
+		}
+		new_intern->count = old_intern->count;
+	}
+
+	return new_obj;
+}
+
+void packettemplate_module_init(void)
+{
+	pocketmine_utils_packettemplate_ce->create_object = packettemplate_create_object;
+	memcpy(&packettemplate_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	packettemplate_handlers.offset = XtOffsetOf(packettemplate_object, std);
+	packettemplate_handlers.free_obj = packettemplate_free_object;
+	packettemplate_handlers.clone_obj = packettemplate_clone_object;
+}
+
+/**
+ * Encodes the packet once with the schema and remembers where each of the
+ * patchable fields was written
+ */
+int packettemplate_compile(zval *return_value, zval *tpl, zval *schema, zval *values, zval *patchable)
+{
+	packettemplate_object *intern = packettemplate_fetch(Z_OBJ_P(tpl));
+	packetschema_object *layout = packetschema_fetch(Z_OBJ_P(schema));
+	packettemplate_patch *patch;
+	unsigned char *wanted;
+	size_t *marks = NULL;
+	const char *bytes;
+	size_t len;
+	uint32_t i, count = 0;
+	zval stream, *name;
+	int status = FAILURE;
+
+	if (Z_TYPE_P(patchable) != IS_ARRAY) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Patchable fields must be an array"));
+		return FAILURE;
+	}
+	ZVAL_UNDEF(&stream);
+	wanted = ecalloc(layout->count + 1, 1);
+
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(patchable), name) {
+		ZVAL_DEREF(name);
+		if (Z_TYPE_P(name) != IS_STRING) {
+			zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Patchable field names must be strings"));
+			goto done;
+		}
+		for (i = 0; i < layout->count && !zend_string_equals(layout->fields[i].name, Z_STR_P(name)); i++);
+		if (i == layout->count) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown field \"%s\"", Z_STRVAL_P(name));
+			goto done;
+		}
+		count += !wanted[i];
+		wanted[i] = 1;
+	} ZEND_HASH_FOREACH_END();
+
+	marks = safe_emalloc(layout->count + 1, sizeof(size_t), 0);
+	binarystream_init_empty(&stream, 0);
+	if (packetschema_encode_marked(schema, &stream, values, marks) == FAILURE) {
+		goto done;
+	}
+	bytes = binarystream_bytes_of(&stream, &len);
+
+	packettemplate_release(intern);
+	intern->bytes = zend_string_init(bytes, len, 0);
+	if (count) {
+		intern->patches = safe_emalloc(count, sizeof(packettemplate_patch), 0);
+		for (i = 0, patch = intern->patches; i < layout->count; i++) {
+			if (wanted[i]) {
+				patch->field = layout->fields[i];
+				zend_string_addref(patch->field.name);
+				patch->offset = marks[i];
+				patch->len = marks[i + 1] - marks[i];
+				patch++;
+			}
+		}
+	}
+	intern->count = count;
+	status = SUCCESS;
+
+done:
+	zval_ptr_dtor(&stream);
+	if (marks) {
+		efree(marks);
+	}
+	efree(wanted);
+	return status;
+}
+
+/**
+ * Returns the template behind tpl, or NULL after throwing when it was never
+ * compiled, e.g. by a subclass constructor not calling the parent one
+ */
+static packettemplate_object *template_of(zval *tpl)
+{
+	packettemplate_object *intern = packettemplate_fetch(Z_OBJ_P(tpl));
+
+	if (UNEXPECTED(intern->bytes == NULL)) {
+		zephir_throw_exception_string(spl_ce_RuntimeException, SL("Template was not compiled"));
+		return NULL;
+	}
+	return intern;
+}
+
+static zend_always_inline void copy_bytes(zval *stream, const char *src, size_t len)
+{
+	if (len) {
+		memcpy(binarystream_write_ptr(stream, len), src, len);
+	}
+}
+
+/**
+ * Appends a copy of the template with the fields in patches encoded again
+ * from their new values; the other fields keep their template bytes
+ */
+static int template_write(packettemplate_object *intern, zval *stream, HashTable *patches)
+{
+	const char *src = ZSTR_VAL(intern->bytes);
+	const packettemplate_patch *patch;
+	size_t pos = 0;
+	zval *value;
+	uint32_t i;
+
+	for (i = 0; i < intern->count; i++) {
+		patch = &intern->patches[i];
+		value = zend_hash_find(patches, patch->field.name);
+		if (value == NULL) {
+			continue;
+		}
+		copy_bytes(stream, src + pos, patch->offset - pos);
+		if (packetschema_encode_field(value, &patch->field, stream) == FAILURE) {
+			return FAILURE;
+		}
+		pos = patch->offset + patch->len;
+	}
+	copy_bytes(stream, src + pos, ZSTR_LEN(intern->bytes) - pos);
+	return SUCCESS;
+}
+
+static const packettemplate_patch *find_patch(packettemplate_object *intern, zend_string *name)
+{
+	uint32_t i;
+
+	for (i = 0; i < intern->count; i++) {
+		if (zend_string_equals(intern->patches[i].field.name, name)) {
+			return &intern->patches[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Throws unless every key of patches names a patchable field
+ */
+static int check_patches(packettemplate_object *intern, HashTable *patches)
+{
+	zend_string *name;
+	zend_ulong index;
+	uint32_t i, found = 0;
+
+	for (i = 0; i < intern->count; i++) {
+		found += zend_hash_exists(patches, intern->patches[i].field.name);
+	}
+	if (found == zend_hash_num_elements(patches)) {
+		return SUCCESS;
+	}
+	ZEND_HASH_FOREACH_KEY(patches, index, name) {
+		if (name == NULL) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Field name must be a string, got " ZEND_ULONG_FMT, index);
+			return FAILURE;
+		}
+		if (find_patch(intern, name) == NULL) {
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Field \"%s\" is not patchable", ZSTR_VAL(name));
+			return FAILURE;
+		}
+	} ZEND_HASH_FOREACH_END();
+	return FAILURE;
+}
+
+/**
+ * Creates an empty stream with room for a copy of the template in which
+ * every patched varint grew to its longest encoding
+ */
+static void template_stream(zval *return_value, packettemplate_object *intern)
+{
+	binarystream_init_empty(return_value, ZSTR_LEN(intern->bytes) + intern->count * VARLONG_MAX_BYTES);
+}
+
+/**
+ * PacketTemplate::write(stream, patches): nothing is left in the stream when
+ * a patched field can't be encoded
+ */
+int packettemplate_write(zval *return_value, zval *tpl, zval *stream, zval *patches)
+{
+	packettemplate_object *intern = template_of(tpl);
+	size_t start;
+
+	if (intern == NULL || check_patches(intern, Z_ARRVAL_P(patches)) == FAILURE) {
+		return FAILURE;
+	}
+	start = binarystream_length(stream);
+	if (template_write(intern, stream, Z_ARRVAL_P(patches)) == FAILURE) {
+		binarystream_truncate(stream, start);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+int packettemplate_instantiate(zval *return_value, zval *tpl, zval *patches)
+{
+	packettemplate_object *intern = template_of(tpl);
+
+	if (intern == NULL || check_patches(intern, Z_ARRVAL_P(patches)) == FAILURE) {
+		return FAILURE;
+	}
+	template_stream(return_value, intern);
+	if (template_write(intern, return_value, Z_ARRVAL_P(patches)) == FAILURE) {
+		zval_ptr_dtor(return_value);
+		ZVAL_NULL(return_value);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+/**
+ * Returns one copy of the template per value, with field set to that value;
+ * the copies keep the keys of values
+ */
+int packettemplate_instantiate_all(zval *return_value, zval *tpl, zval *field, zval *values)
+{
+	packettemplate_object *intern = template_of(tpl);
+	HashTable patch;
+	zend_string *key;
+	zend_ulong index;
+	zval *value, copy;
+
+	if (intern == NULL) {
+		return FAILURE;
+	}
+	if (find_patch(intern, Z_STR_P(field)) == NULL) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Field \"%s\" is not patchable", Z_STRVAL_P(field));
+		return FAILURE;
+	}
+	/* holds the current value only, borrowed from values */
+	zend_hash_init(&patch, 1, NULL, NULL, 0);
+	array_init_size(return_value, zend_hash_num_elements(Z_ARRVAL_P(values)));
+
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(values), index, key, value) {
+		zend_hash_update(&patch, Z_STR_P(field), value);
+		template_stream(&copy, intern);
+		if (template_write(intern, &copy, &patch) == FAILURE) {
+			zval_ptr_dtor(&copy);
+			zend_hash_destroy(&patch);
+			zval_ptr_dtor(return_value);
+			ZVAL_NULL(return_value);
+			return FAILURE;
+		}
+		if (key) {
+			zend_hash_add_new(Z_ARRVAL_P(return_value), key, &copy);
+		} else {
+			zend_hash_index_add_new(Z_ARRVAL_P(return_value), index, &copy);
+		}
+	} ZEND_HASH_FOREACH_END();
+
+	zend_hash_destroy(&patch);
+	return SUCCESS;
+}
+
+int packettemplate_bytes(zval *return_value, zval *tpl)
+{
+	packettemplate_object *intern = packettemplate_fetch(Z_OBJ_P(tpl));
+
+	if (intern->bytes == NULL) {
+		ZVAL_EMPTY_STRING(return_value);
+		return SUCCESS;
+	}
+	ZVAL_STR_COPY(return_value, intern->bytes);
+	return SUCCESS;
+}
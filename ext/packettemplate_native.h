@@ -0,0 +1,33 @@
+#ifndef PACKETTEMPLATE_NATIVE_H
+#define PACKETTEMPLATE_NATIVE_H
+
+#include <php.h>
+
+#include "packetschema_native.h"
+
+/* A field of the template that can be given another value per copy */
+typedef struct _packettemplate_patch {
+	packetschema_field field;
+	size_t offset;  /* where its encoding starts in bytes */
+	size_t len;     /* bytes of its encoding in bytes */
+} packettemplate_patch;
+
+/**
+ * Native part of Pocketmine\Utils\PacketTemplate objects
+ */
+typedef struct _packettemplate_object {
+	zend_string *bytes;             /* the packet encoded once */
+	packettemplate_patch *patches;  /* in wire order */
+	uint32_t count;
+	zend_object std;
+} packettemplate_object;
+
+void packettemplate_module_init(void);
+
+int packettemplate_compile(zval *return_value, zval *tpl, zval *schema, zval *values, zval *patchable);
+int packettemplate_write(zval *return_value, zval *tpl, zval *stream, zval *patches);
+int packettemplate_instantiate(zval *return_value, zval *tpl, zval *patches);
+int packettemplate_instantiate_all(zval *return_value, zval *tpl, zval *field, zval *values);
+int packettemplate_bytes(zval *return_value, zval *tpl);
+
+#endif
@@ -0,0 +1,101 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include <math.h>
+
+#include "vector3_native.h"
+
+/* Slots of the declared Vector3 properties, resolved once at MINIT */
+static uint32_t prop_x;
+static uint32_t prop_y;
+static uint32_t prop_z;
+
+void vector3_module_init(void)
+{
+	zend_property_info *info;
+
+	info = zend_hash_str_find_ptr(&pocketmine_math_vector3_ce->properties_info, ZEND_STRL("x"));
+	prop_x = info->offset;
+	info = zend_hash_str_find_ptr(&pocketmine_math_vector3_ce->properties_info, ZEND_STRL("y"));
+	prop_y = info->offset;
+	info = zend_hash_str_find_ptr(&pocketmine_math_vector3_ce->properties_info, ZEND_STRL("z"));
+	prop_z = info->offset;
+}
+
+void vector3_init(zval *return_value, double x, double y, double z)
+{
+	zend_object *obj;
+
+	object_init_ex(return_value, pocketmine_math_vector3_ce);
+	obj = Z_OBJ_P(return_value);
+	/* the defaults are doubles, so there is nothing to release */
+	ZVAL_DOUBLE(OBJ_PROP(obj, prop_x), x);
+	ZVAL_DOUBLE(OBJ_PROP(obj, prop_y), y);
+	ZVAL_DOUBLE(OBJ_PROP(obj, prop_z), z);
+}
+
+void vector3_init_long(zval *return_value, zend_long x, zend_long y, zend_long z)
+{
+	zend_object *obj;
+
+	object_init_ex(return_value, pocketmine_math_vector3_ce);
+	obj = Z_OBJ_P(return_value);
+	ZVAL_LONG(OBJ_PROP(obj, prop_x), x);
+	ZVAL_LONG(OBJ_PROP(obj, prop_y), y);
+	ZVAL_LONG(OBJ_PROP(obj, prop_z), z);
+}
+
+static zend_always_inline double component(zend_object *obj, uint32_t offset)
+{
+	zval *zv = OBJ_PROP(obj, offset);
+
+	ZVAL_DEREF(zv);
+	return Z_TYPE_P(zv) == IS_DOUBLE ? Z_DVAL_P(zv) : zval_get_double(zv);
+}
+
+int vector3_components(zval *vector, double *x, double *y, double *z)
+{
+	zend_object *obj;
+
+	if (Z_TYPE_P(vector) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(vector), pocketmine_math_vector3_ce)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Expected a Vector3"));
+		return FAILURE;
+	}
+	obj = Z_OBJ_P(vector);
+	*x = component(obj, prop_x);
+	*y = component(obj, prop_y);
+	*z = component(obj, prop_z);
+	return SUCCESS;
+}
+
+static zend_always_inline zend_long floor_component(zend_object *obj, uint32_t offset)
+{
+	zval *zv = OBJ_PROP(obj, offset);
+
+	ZVAL_DEREF(zv);
+	return Z_TYPE_P(zv) == IS_LONG ? Z_LVAL_P(zv) : (zend_long) floor(zval_get_double(zv));
+}
+
+int vector3_floor_components(zval *vector, zend_long *x, zend_long *y, zend_long *z)
+{
+	zend_object *obj;
+
+	if (Z_TYPE_P(vector) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(vector), pocketmine_math_vector3_ce)) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Expected a Vector3"));
+		return FAILURE;
+	}
+	obj = Z_OBJ_P(vector);
+	*x = floor_component(obj, prop_x);
+	*y = floor_component(obj, prop_y);
+	*z = floor_component(obj, prop_z);
+	return SUCCESS;
+}
@@ -0,0 +1,18 @@
+#ifndef VECTOR3_NATIVE_H
+#define VECTOR3_NATIVE_H
+
+#include <php.h>
+
+void vector3_module_init(void);
+
+/* Creates a Pocketmine\Math\Vector3 without calling its constructor */
+void vector3_init(zval *return_value, double x, double y, double z);
+/* Same with integer components, like the block positions made by Vector3::floor() */
+void vector3_init_long(zval *return_value, zend_long x, zend_long y, zend_long z);
+
+/* Reads the components of a Vector3, throws InvalidArgumentException for anything else */
+int vector3_components(zval *vector, double *x, double *y, double *z);
+/* Same, rounding down like the getFloor*() methods; integer components are returned as they are */
+int vector3_floor_components(zval *vector, zend_long *x, zend_long *y, zend_long *z);
+
+#endif
@@ -0,0 +1,370 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include <zlib.h>
+#ifdef HAVE_LIBDEFLATE
+/* opt in with CFLAGS=-DHAVE_LIBDEFLATE LDFLAGS=-ldeflate */
+#include <libdeflate.h>
+#endif
+
+#include "binarystream_native.h"
+#include "zlib_native.h"
+
+#define ENCODINGS 3
+#define LEVELS    10
+
+/* Smallest output buffer a decompression starts with */
+#define INFLATE_MIN_CAPACITY 4096
+
+/*
+ * Contexts are created on first use and reset between calls instead of
+ * being set up again for every batch. They live until the end of the request.
+ */
+static ZEND_TLS z_stream *deflaters[ENCODINGS][LEVELS];
+static ZEND_TLS z_stream *inflaters[ENCODINGS];
+#ifdef HAVE_LIBDEFLATE
+static ZEND_TLS struct libdeflate_compressor *compressors[LEVELS];
+static ZEND_TLS struct libdeflate_decompressor *decompressor;
+#endif
+
+static int encoding_index(zend_long encoding)
+{
+	switch (encoding) {
+		case ZLIB_NATIVE_RAW:     return 0;
+		case ZLIB_NATIVE_DEFLATE: return 1;
+		case ZLIB_NATIVE_GZIP:    return 2;
+	}
+	zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unsupported encoding " ZEND_LONG_FMT, encoding);
+	return -1;
+}
+
+#ifndef HAVE_LIBDEFLATE
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+	return safe_emalloc(items, size, 0);
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+	efree(address);
+}
+
+static z_stream *get_deflater(int encoding, zend_long window, int level)
+{
+	z_stream *strm = deflaters[encoding][level];
+
+	if (strm != NULL) {
+		deflateReset(strm);
+		return strm;
+	}
+	strm = ecalloc(1, sizeof(z_stream));
+	strm->zalloc = zlib_alloc;
+	strm->zfree = zlib_free;
+	if (deflateInit2(strm, level, Z_DEFLATED, (int) window, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		efree(strm);
+		return NULL;
+	}
+	deflaters[encoding][level] = strm;
+	return strm;
+}
+
+static z_stream *get_inflater(int encoding, zend_long window)
+{
+	z_stream *strm = inflaters[encoding];
+
+	if (strm != NULL) {
+		inflateReset(strm);
+		return strm;
+	}
+	strm = ecalloc(1, sizeof(z_stream));
+	strm->zalloc = zlib_alloc;
+	strm->zfree = zlib_free;
+	if (inflateInit2(strm, (int) window) != Z_OK) {
+		efree(strm);
+		return NULL;
+	}
+	inflaters[encoding] = strm;
+	return strm;
+}
+#endif
+
+void zlib_native_request_shutdown(void)
+{
+	int i, j;
+
+	for (i = 0; i < ENCODINGS; i++) {
+		for (j = 0; j < LEVELS; j++) {
+			if (deflaters[i][j]) {
+				deflateEnd(deflaters[i][j]);
+				efree(deflaters[i][j]);
+				deflaters[i][j] = NULL;
+			}
+		}
+		if (inflaters[i]) {
+			inflateEnd(inflaters[i]);
+			efree(inflaters[i]);
+			inflaters[i] = NULL;
+		}
+	}
+#ifdef HAVE_LIBDEFLATE
+	for (j = 0; j < LEVELS; j++) {
+		if (compressors[j]) {
+			libdeflate_free_compressor(compressors[j]);
+			compressors[j] = NULL;
+		}
+	}
+	if (decompressor) {
+		libdeflate_free_decompressor(decompressor);
+		decompressor = NULL;
+	}
+#endif
+}
+
+/**
+ * Gives back the unused tail of a result buffer when it is a sizable part of it
+ */
+static zend_string *shrink(zend_string *out, size_t len, size_t *capacity)
+{
+	ZSTR_LEN(out) = len;
+	ZSTR_VAL(out)[len] = '\0';
+	if (*capacity - len > len / 4 + 64) {
+		out = zend_string_truncate(out, len, 0);
+		*capacity = len;
+	}
+	return out;
+}
+
+#ifndef HAVE_LIBDEFLATE
+/**
+ * Compresses a segmented BinaryStream one segment at a time instead of
+ * flattening it first. The output starts at the bound of the whole input and
+ * grows should deflate() need more.
+ */
+static int compress_pieces(zval *return_value, zval *input, int encoding, zend_long window, int level)
+{
+	z_stream *strm = get_deflater(encoding, window, level);
+	const char *ptr;
+	size_t len, total = 0, capacity, i;
+	zend_string *out;
+	int flush, status = Z_OK;
+
+	if (strm == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to initialize a deflate stream");
+	}
+	for (i = 0; binarystream_piece(input, i, &len) != NULL; i++) {
+		total += len;
+	}
+	capacity = deflateBound(strm, (uLong) total);
+	out = zend_string_alloc(capacity, 0);
+	strm->next_out = (Bytef *) ZSTR_VAL(out);
+	strm->avail_out = (uInt) capacity;
+
+	for (i = 0; status == Z_OK; i++) {
+		ptr = binarystream_piece(input, i, &len);
+		if (ptr != NULL && len == 0) {
+			continue;
+		}
+		flush = ptr != NULL ? Z_NO_FLUSH : Z_FINISH;
+		strm->next_in = (Bytef *) ptr;
+		strm->avail_in = ptr != NULL ? (uInt) len : 0;
+		do {
+			if (strm->avail_out == 0) {
+				out = zend_string_extend(out, capacity * 2, 0);
+				strm->next_out = (Bytef *) ZSTR_VAL(out) + strm->total_out;
+				strm->avail_out = (uInt) capacity;
+				capacity *= 2;
+			}
+			status = deflate(strm, flush);
+		} while (status == Z_OK && (flush == Z_FINISH || strm->avail_in != 0));
+	}
+	if (status != Z_STREAM_END) {
+		zend_string_efree(out);
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("Compression failed"));
+		return FAILURE;
+	}
+
+	out = shrink(out, strm->total_out, &capacity);
+	binarystream_init_owned(return_value, out, capacity);
+	return SUCCESS;
+}
+#endif
+
+/**
+ * Compresses a string or the buffer of a BinaryStream into a new BinaryStream.
+ * The output is allocated at its worst-case size, so one pass always finishes.
+ */
+int zlib_native_compress(zval *return_value, zval *input, zval *level_zv, zval *encoding_zv)
+{
+	zend_long level = zval_get_long(level_zv), window = zval_get_long(encoding_zv);
+	int encoding = encoding_index(window);
+	const char *bytes;
+	size_t len, capacity, produced;
+	zend_string *out;
+#ifndef HAVE_LIBDEFLATE
+	z_stream *strm;
+#endif
+
+	if (encoding < 0) {
+		return FAILURE;
+	}
+	if (level < -1 || level > 9) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Compression level " ZEND_LONG_FMT " must be between -1 and 9", level);
+		return FAILURE;
+	}
+	if (level == -1) {
+		level = 6;
+	}
+#ifndef HAVE_LIBDEFLATE
+	if (binarystream_piece(input, 1, &len) != NULL) {
+		return compress_pieces(return_value, input, encoding, window, (int) level);
+	}
+#endif
+	bytes = binarystream_bytes_of(input, &len);
+	if (bytes == NULL) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Input must be a string or a BinaryStream"));
+		return FAILURE;
+	}
+
+#ifdef HAVE_LIBDEFLATE
+	if (compressors[level] == NULL && (compressors[level] = libdeflate_alloc_compressor((int) level)) == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to allocate a compressor");
+	}
+	switch (encoding) {
+		case 0:  capacity = libdeflate_deflate_compress_bound(compressors[level], len); break;
+		case 1:  capacity = libdeflate_zlib_compress_bound(compressors[level], len); break;
+		default: capacity = libdeflate_gzip_compress_bound(compressors[level], len); break;
+	}
+	out = zend_string_alloc(capacity, 0);
+	switch (encoding) {
+		case 0:  produced = libdeflate_deflate_compress(compressors[level], bytes, len, ZSTR_VAL(out), capacity); break;
+		case 1:  produced = libdeflate_zlib_compress(compressors[level], bytes, len, ZSTR_VAL(out), capacity); break;
+		default: produced = libdeflate_gzip_compress(compressors[level], bytes, len, ZSTR_VAL(out), capacity); break;
+	}
+#else
+	strm = get_deflater(encoding, window, (int) level);
+	if (strm == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to initialize a deflate stream");
+	}
+	capacity = deflateBound(strm, (uLong) len);
+	out = zend_string_alloc(capacity, 0);
+	strm->next_in = (Bytef *) bytes;
+	strm->avail_in = (uInt) len;
+	strm->next_out = (Bytef *) ZSTR_VAL(out);
+	strm->avail_out = (uInt) capacity;
+	if (deflate(strm, Z_FINISH) != Z_STREAM_END) {
+		zend_string_efree(out);
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("Compression failed"));
+		return FAILURE;
+	}
+	produced = strm->total_out;
+#endif
+
+	out = shrink(out, produced, &capacity);
+	binarystream_init_owned(return_value, out, capacity);
+	return SUCCESS;
+}
+
+/**
+ * Decompresses a string or the buffer of a BinaryStream into a new
+ * BinaryStream. Output beyond max_length bytes is never produced: the data is
+ * rejected instead, so a small bomb cannot allocate more than the cap.
+ */
+int zlib_native_decompress(zval *return_value, zval *input, zval *max_length_zv, zval *encoding_zv)
+{
+	zend_long max_length = zval_get_long(max_length_zv), window = zval_get_long(encoding_zv);
+	int encoding = encoding_index(window);
+	const char *bytes;
+	size_t len, capacity, limit, produced = 0;
+	zend_string *out;
+	int status;
+#ifdef HAVE_LIBDEFLATE
+	enum libdeflate_result result;
+#else
+	z_stream *strm;
+#endif
+
+	if (encoding < 0) {
+		return FAILURE;
+	}
+	if (max_length <= 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum length must be positive"));
+		return FAILURE;
+	}
+	bytes = binarystream_bytes_of(input, &len);
+	if (bytes == NULL) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Input must be a string or a BinaryStream"));
+		return FAILURE;
+	}
+
+	/* one byte over the cap tells a stream that is exactly max_length long from a longer one */
+	limit = (size_t) max_length + 1;
+	capacity = len > (limit / 4) ? limit : len * 4;
+	if (capacity < INFLATE_MIN_CAPACITY) {
+		capacity = INFLATE_MIN_CAPACITY < limit ? INFLATE_MIN_CAPACITY : limit;
+	}
+	out = zend_string_alloc(capacity, 0);
+
+#ifdef HAVE_LIBDEFLATE
+	if (decompressor == NULL && (decompressor = libdeflate_alloc_decompressor()) == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to allocate a decompressor");
+	}
+	for (;;) {
+		switch (encoding) {
+			case 0:  result = libdeflate_deflate_decompress(decompressor, bytes, len, ZSTR_VAL(out), capacity, &produced); break;
+			case 1:  result = libdeflate_zlib_decompress(decompressor, bytes, len, ZSTR_VAL(out), capacity, &produced); break;
+			default: result = libdeflate_gzip_decompress(decompressor, bytes, len, ZSTR_VAL(out), capacity, &produced); break;
+		}
+		if (result != LIBDEFLATE_INSUFFICIENT_SPACE || capacity == limit) {
+			break;
+		}
+		capacity = capacity > limit / 2 ? limit : capacity * 2;
+		out = zend_string_extend(out, capacity, 0);
+	}
+	status = result == LIBDEFLATE_SUCCESS ? Z_STREAM_END : (result == LIBDEFLATE_INSUFFICIENT_SPACE ? Z_BUF_ERROR : Z_DATA_ERROR);
+	if (status == Z_BUF_ERROR) {
+		produced = limit;
+	}
+#else
+	strm = get_inflater(encoding, window);
+	if (strm == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to initialize an inflate stream");
+	}
+	strm->next_in = (Bytef *) bytes;
+	strm->avail_in = (uInt) len;
+	for (;;) {
+		strm->next_out = (Bytef *) ZSTR_VAL(out) + produced;
+		strm->avail_out = (uInt) (capacity - produced);
+		status = inflate(strm, Z_NO_FLUSH);
+		produced = capacity - strm->avail_out;
+		if (status != Z_OK || strm->avail_out != 0 || capacity == limit) {
+			break;
+		}
+		capacity = capacity > limit / 2 ? limit : capacity * 2;
+		out = zend_string_extend(out, capacity, 0);
+	}
+#endif
+
+	if (produced >= limit) {
+		zend_string_efree(out);
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Decompressed data exceeds the maximum length of " ZEND_LONG_FMT " bytes", max_length);
+		return FAILURE;
+	}
+	if (status != Z_STREAM_END) {
+		zend_string_efree(out);
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("Failed to decompress data"));
+		return FAILURE;
+	}
+
+	out = shrink(out, produced, &capacity);
+	binarystream_init_owned(return_value, out, capacity);
+	return SUCCESS;
+}
@@ -0,0 +1,16 @@
+#ifndef ZLIB_NATIVE_H
+#define ZLIB_NATIVE_H
+
+#include <php.h>
+
+/* Window bits of the supported formats, same values as PHP's ZLIB_ENCODING_* */
+#define ZLIB_NATIVE_RAW     -15
+#define ZLIB_NATIVE_DEFLATE  15
+#define ZLIB_NATIVE_GZIP     31
+
+void zlib_native_request_shutdown(void);
+
+int zlib_native_compress(zval *return_value, zval *input, zval *level, zval *encoding);
+int zlib_native_decompress(zval *return_value, zval *input, zval *max_length, zval *encoding);
+
+#endif
@@ -0,0 +1,581 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_ext.h"
+#include "rapidpm.h"
+
+#include "kernel/main.h"
+#include "kernel/exception.h"
+#include "ext/spl/spl_exceptions.h"
+
+#include <zlib.h>
+#ifndef PHP_WIN32
+#include <pthread.h>
+#endif
+
+#include "binarystream_native.h"
+#include "zlib_native.h"
+#include "zlib_pool.h"
+
+/*
+ * Every PHP thread has a pool of its own, with its own workers and handles,
+ * so jobs are only ever pinned, collected and dropped by the thread that
+ * submitted them. Worker threads only ever see plain malloc() memory and the
+ * bytes of pinned strings: the input string is referenced on submit and
+ * released by the thread that collects the job, and the output is copied
+ * into a zend_string by that thread too. On Windows jobs run when they are
+ * submitted.
+ */
+
+#define ZLIB_POOL_DEFAULT_WORKERS 4
+#define ZLIB_POOL_MAX_WORKERS     64
+
+#define ENCODINGS 3
+#define LEVELS    10
+
+typedef enum _zlib_job_state {
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,
+	JOB_FAILED,
+	JOB_TOO_LONG
+} zlib_job_state;
+
+typedef struct _zlib_job {
+	struct _zlib_job *next;      /* in the queue while queued */
+	struct _zlib_job *all_next;  /* every submitted job */
+	zend_long id;
+	int decompress;
+	int encoding;                /* index of the window bits below */
+	int window;
+	int level;
+	size_t max_length;
+	zend_refcounted *pinned;     /* only touched by the submitting thread */
+	const char *in;
+	size_t in_len;
+	char *out;                   /* malloc()ed by the worker */
+	size_t out_len;
+	zlib_job_state state;
+} zlib_job;
+
+/* Deflate contexts of one worker, reused between its jobs */
+typedef struct _zlib_contexts {
+	z_stream *deflaters[ENCODINGS][LEVELS];
+	z_stream *inflaters[ENCODINGS];
+} zlib_contexts;
+
+typedef struct _zlib_pool {
+#ifndef PHP_WIN32
+	pthread_mutex_t lock;
+	pthread_cond_t work;         /* signalled when a job is queued or on stop */
+	pthread_cond_t done;         /* broadcast when a job finishes */
+	pthread_t threads[ZLIB_POOL_MAX_WORKERS];
+#endif
+	int workers;
+	int stopping;
+	zlib_job *head, *tail;       /* queued jobs */
+	zlib_job *jobs;              /* every job not collected yet */
+	zend_long next_id;
+} zlib_pool;
+
+/* Pool of the current thread, created on first use */
+static ZEND_TLS zlib_pool *pool;
+
+static z_stream *worker_deflater(zlib_contexts *ctx, zlib_job *job)
+{
+	z_stream *strm = ctx->deflaters[job->encoding][job->level];
+
+	if (strm != NULL) {
+		deflateReset(strm);
+		return strm;
+	}
+	strm = calloc(1, sizeof(z_stream));
+	if (strm == NULL || deflateInit2(strm, job->level, Z_DEFLATED, job->window, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		free(strm);
+		return NULL;
+	}
+	ctx->deflaters[job->encoding][job->level] = strm;
+	return strm;
+}
+
+static z_stream *worker_inflater(zlib_contexts *ctx, zlib_job *job)
+{
+	z_stream *strm = ctx->inflaters[job->encoding];
+
+	if (strm != NULL) {
+		inflateReset(strm);
+		return strm;
+	}
+	strm = calloc(1, sizeof(z_stream));
+	if (strm == NULL || inflateInit2(strm, job->window) != Z_OK) {
+		free(strm);
+		return NULL;
+	}
+	ctx->inflaters[job->encoding] = strm;
+	return strm;
+}
+
+static void free_contexts(zlib_contexts *ctx)
+{
+	int i, j;
+
+	for (i = 0; i < ENCODINGS; i++) {
+		for (j = 0; j < LEVELS; j++) {
+			if (ctx->deflaters[i][j]) {
+				deflateEnd(ctx->deflaters[i][j]);
+				free(ctx->deflaters[i][j]);
+			}
+		}
+		if (ctx->inflaters[i]) {
+			inflateEnd(ctx->inflaters[i]);
+			free(ctx->inflaters[i]);
+		}
+	}
+}
+
+static zlib_job_state run_compress(zlib_contexts *ctx, zlib_job *job)
+{
+	z_stream *strm = worker_deflater(ctx, job);
+	size_t capacity;
+
+	if (strm == NULL) {
+		return JOB_FAILED;
+	}
+	capacity = deflateBound(strm, (uLong) job->in_len);
+	if ((job->out = malloc(capacity)) == NULL) {
+		return JOB_FAILED;
+	}
+	strm->next_in = (Bytef *) job->in;
+	strm->avail_in = (uInt) job->in_len;
+	strm->next_out = (Bytef *) job->out;
+	strm->avail_out = (uInt) capacity;
+	if (deflate(strm, Z_FINISH) != Z_STREAM_END) {
+		return JOB_FAILED;
+	}
+	job->out_len = strm->total_out;
+	return JOB_DONE;
+}
+
+/**
+ * Inflates with the same growth and cap as Zlib::decompress()
+ */
+static zlib_job_state run_decompress(zlib_contexts *ctx, zlib_job *job)
+{
+	z_stream *strm = worker_inflater(ctx, job);
+	size_t limit = job->max_length + 1, capacity, produced = 0;
+	char *grown;
+	int status;
+
+	if (strm == NULL) {
+		return JOB_FAILED;
+	}
+	capacity = job->in_len > limit / 4 ? limit : job->in_len * 4;
+	if (capacity < 4096) {
+		capacity = 4096 < limit ? 4096 : limit;
+	}
+	if ((job->out = malloc(capacity)) == NULL) {
+		return JOB_FAILED;
+	}
+	strm->next_in = (Bytef *) job->in;
+	strm->avail_in = (uInt) job->in_len;
+	for (;;) {
+		strm->next_out = (Bytef *) job->out + produced;
+		strm->avail_out = (uInt) (capacity - produced);
+		status = inflate(strm, Z_NO_FLUSH);
+		produced = capacity - strm->avail_out;
+		if (status != Z_OK || strm->avail_out != 0 || capacity == limit) {
+			break;
+		}
+		capacity = capacity > limit / 2 ? limit : capacity * 2;
+		if ((grown = realloc(job->out, capacity)) == NULL) {
+			return JOB_FAILED;
+		}
+		job->out = grown;
+	}
+	if (produced >= limit) {
+		return JOB_TOO_LONG;
+	}
+	if (status != Z_STREAM_END) {
+		return JOB_FAILED;
+	}
+	job->out_len = produced;
+	return JOB_DONE;
+}
+
+static zlib_job_state run_job(zlib_contexts *ctx, zlib_job *job)
+{
+	return job->decompress ? run_decompress(ctx, job) : run_compress(ctx, job);
+}
+
+#ifndef PHP_WIN32
+static void *worker_main(void *arg)
+{
+	zlib_pool *owner = arg;
+	zlib_contexts ctx;
+	zlib_job *job;
+	zlib_job_state state;
+
+	memset(&ctx, 0, sizeof(ctx));
+	pthread_mutex_lock(&owner->lock);
+	for (;;) {
+		while (owner->head == NULL && !owner->stopping) {
+			pthread_cond_wait(&owner->work, &owner->lock);
+		}
+		if (owner->stopping) {
+			break;
+		}
+		job = owner->head;
+		owner->head = job->next;
+		if (owner->head == NULL) {
+			owner->tail = NULL;
+		}
+		job->state = JOB_RUNNING;
+		pthread_mutex_unlock(&owner->lock);
+
+		state = run_job(&ctx, job);
+
+		pthread_mutex_lock(&owner->lock);
+		job->state = state;
+		pthread_cond_broadcast(&owner->done);
+	}
+	pthread_mutex_unlock(&owner->lock);
+	free_contexts(&ctx);
+	return NULL;
+}
+#endif
+
+/**
+ * Returns the pool of the current thread, creating it if needed
+ */
+static zlib_pool *thread_pool(void)
+{
+	if (pool != NULL) {
+		return pool;
+	}
+	pool = calloc(1, sizeof(zlib_pool));
+	if (pool == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to allocate a compression pool");
+	}
+#ifndef PHP_WIN32
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->done, NULL);
+#endif
+	pool->next_id = 1;
+	return pool;
+}
+
+static int start_workers(zlib_pool *p, int workers)
+{
+#ifndef PHP_WIN32
+	int i;
+
+	p->stopping = 0;
+	for (i = 0; i < workers; i++) {
+		if (pthread_create(&p->threads[i], NULL, worker_main, p) != 0) {
+			break;
+		}
+	}
+	p->workers = i;
+	if (i == 0) {
+		zephir_throw_exception_string(spl_ce_RuntimeException, SL("Unable to start compression worker threads"));
+		return FAILURE;
+	}
+#else
+	p->workers = workers;
+#endif
+	return SUCCESS;
+}
+
+static void stop_workers(zlib_pool *p)
+{
+#ifndef PHP_WIN32
+	int i;
+
+	pthread_mutex_lock(&p->lock);
+	p->stopping = 1;
+	pthread_cond_broadcast(&p->work);
+	pthread_mutex_unlock(&p->lock);
+	for (i = 0; i < p->workers; i++) {
+		pthread_join(p->threads[i], NULL);
+	}
+	p->stopping = 0;
+#endif
+	p->workers = 0;
+}
+
+static void free_job(zlib_job *job)
+{
+	if (job->pinned) {
+		binarystream_unpin(job->pinned);
+	}
+	free(job->out);
+	free(job);
+}
+
+/**
+ * Stops the workers of the current thread and drops every job it did not
+ * collect; pools of other threads are left alone
+ */
+void zlib_pool_request_shutdown(void)
+{
+	zlib_job *job, *next;
+
+	if (pool == NULL) {
+		return;
+	}
+	stop_workers(pool);
+	for (job = pool->jobs; job != NULL; job = next) {
+		next = job->all_next;
+		free_job(job);
+	}
+#ifndef PHP_WIN32
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+#endif
+	free(pool);
+	pool = NULL;
+}
+
+/**
+ * ZlibPool::start(workers): starts the pool with the given number of threads
+ */
+int zlib_pool_start(zval *return_value, zval *workers_zv)
+{
+	zend_long workers = zval_get_long(workers_zv);
+	zlib_pool *p;
+
+	if (workers < 1 || workers > ZLIB_POOL_MAX_WORKERS) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Worker count must be between 1 and %d", ZLIB_POOL_MAX_WORKERS);
+		return FAILURE;
+	}
+	p = thread_pool();
+	if (p->workers != 0) {
+		if (p->workers == workers) {
+			return SUCCESS;
+		}
+		zephir_throw_exception_string(spl_ce_RuntimeException, SL("The compression pool is already running"));
+		return FAILURE;
+	}
+	return start_workers(p, (int) workers);
+}
+
+static int submit(zval *return_value, zval *input, int decompress, zend_long level, zend_long window, zend_long max_length)
+{
+	zlib_pool *p;
+	zlib_job *job;
+	int encoding;
+
+	switch (window) {
+		case ZLIB_NATIVE_RAW:     encoding = 0; break;
+		case ZLIB_NATIVE_DEFLATE: encoding = 1; break;
+		case ZLIB_NATIVE_GZIP:    encoding = 2; break;
+		default:
+			zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unsupported encoding " ZEND_LONG_FMT, window);
+			return FAILURE;
+	}
+	p = thread_pool();
+	if (p->workers == 0 && start_workers(p, ZLIB_POOL_DEFAULT_WORKERS) == FAILURE) {
+		return FAILURE;
+	}
+	job = calloc(1, sizeof(zlib_job));
+	if (job == NULL) {
+		zend_error_noreturn(E_ERROR, "Unable to allocate a compression job");
+	}
+	job->pinned = binarystream_pin(input, &job->in, &job->in_len);
+	if (job->pinned == NULL) {
+		free(job);
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Input must be a string or a BinaryStream"));
+		return FAILURE;
+	}
+	job->decompress = decompress;
+	job->encoding = encoding;
+	job->window = (int) window;
+	job->level = (int) level;
+	job->max_length = (size_t) max_length;
+	job->id = p->next_id++;
+	job->state = JOB_QUEUED;
+
+#ifndef PHP_WIN32
+	pthread_mutex_lock(&p->lock);
+	job->all_next = p->jobs;
+	p->jobs = job;
+	if (p->tail) {
+		p->tail->next = job;
+	} else {
+		p->head = job;
+	}
+	p->tail = job;
+	pthread_cond_signal(&p->work);
+	pthread_mutex_unlock(&p->lock);
+#else
+	{
+		zlib_contexts ctx;
+
+		memset(&ctx, 0, sizeof(ctx));
+		job->state = run_job(&ctx, job);
+		free_contexts(&ctx);
+		job->all_next = p->jobs;
+		p->jobs = job;
+	}
+#endif
+
+	ZVAL_LONG(return_value, job->id);
+	return SUCCESS;
+}
+
+int zlib_pool_submit_compress(zval *return_value, zval *input, zval *level_zv, zval *encoding)
+{
+	zend_long level = zval_get_long(level_zv);
+
+	if (level < -1 || level > 9) {
+		zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Compression level " ZEND_LONG_FMT " must be between -1 and 9", level);
+		return FAILURE;
+	}
+	return submit(return_value, input, 0, level == -1 ? 6 : level, zval_get_long(encoding), 0);
+}
+
+int zlib_pool_submit_decompress(zval *return_value, zval *input, zval *max_length_zv, zval *encoding)
+{
+	zend_long max_length = zval_get_long(max_length_zv);
+
+	if (max_length <= 0) {
+		zephir_throw_exception_string(spl_ce_InvalidArgumentException, SL("Maximum length must be positive"));
+		return FAILURE;
+	}
+	return submit(return_value, input, 1, 0, zval_get_long(encoding), max_length);
+}
+
+/**
+ * Returns the job of a handle of the current thread; the pool lock must be
+ * held
+ */
+static zlib_job *find_job(zlib_pool *owner, zend_long id, zlib_job ***link)
+{
+	zlib_job **p;
+
+	for (p = &owner->jobs; *p != NULL; p = &(*p)->all_next) {
+		if ((*p)->id == id) {
+			if (link) {
+				*link = p;
+			}
+			return *p;
+		}
+	}
+	zephir_throw_exception_format(spl_ce_InvalidArgumentException, "Unknown compression handle " ZEND_LONG_FMT, id);
+	return NULL;
+}
+
+static zend_always_inline void pool_lock(zlib_pool *p)
+{
+#ifndef PHP_WIN32
+	pthread_mutex_lock(&p->lock);
+#endif
+}
+
+static zend_always_inline void pool_unlock(zlib_pool *p)
+{
+#ifndef PHP_WIN32
+	pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+/**
+ * ZlibPool::poll(handle): whether the job has finished
+ */
+int zlib_pool_poll(zval *return_value, zval *handle)
+{
+	zlib_pool *p = thread_pool();
+	zlib_job *job;
+
+	pool_lock(p);
+	job = find_job(p, zval_get_long(handle), NULL);
+	if (job != NULL) {
+		ZVAL_BOOL(return_value, job->state >= JOB_DONE);
+	}
+	pool_unlock(p);
+	return job != NULL ? SUCCESS : FAILURE;
+}
+
+/**
+ * ZlibPool::ready(): handles of every finished job, oldest first
+ */
+int zlib_pool_ready(zval *return_value)
+{
+	zlib_pool *p = thread_pool();
+	zlib_job *job;
+	zend_long *ids;
+	uint32_t count = 0, i;
+
+	pool_lock(p);
+	for (job = p->jobs; job != NULL; job = job->all_next) {
+		count += job->state >= JOB_DONE;
+	}
+	array_init_size(return_value, count);
+	if (count == 0) {
+		pool_unlock(p);
+		return SUCCESS;
+	}
+	/* jobs are linked newest first */
+	ids = safe_emalloc(count, sizeof(zend_long), 0);
+	i = count;
+	for (job = p->jobs; job != NULL; job = job->all_next) {
+		if (job->state >= JOB_DONE) {
+			ids[--i] = job->id;
+		}
+	}
+	pool_unlock(p);
+	for (i = 0; i < count; i++) {
+		add_next_index_long(return_value, ids[i]);
+	}
+	efree(ids);
+	return SUCCESS;
+}
+
+/**
+ * ZlibPool::collect(handle): waits for the job if needed and returns its
+ * output; the handle is invalid afterwards
+ */
+int zlib_pool_collect(zval *return_value, zval *handle)
+{
+	zlib_pool *p = thread_pool();
+	zlib_job *job, **link;
+	zend_string *out = NULL;
+	zend_long max_length;
+	zlib_job_state state;
+
+	pool_lock(p);
+	job = find_job(p, zval_get_long(handle), &link);
+	if (job == NULL) {
+		pool_unlock(p);
+		return FAILURE;
+	}
+#ifndef PHP_WIN32
+	while (job->state < JOB_DONE) {
+		pthread_cond_wait(&p->done, &p->lock);
+	}
+#endif
+	*link = job->all_next;
+	pool_unlock(p);
+
+	state = job->state;
+	max_length = (zend_long) job->max_length;
+	if (state == JOB_DONE) {
+		out = zend_string_init(job->out, job->out_len, 0);
+	}
+	free_job(job);
+
+	if (state == JOB_TOO_LONG) {
+		zephir_throw_exception_format(pocketmine_utils_binarydataexception_ce, "Decompressed data exceeds the maximum length of " ZEND_LONG_FMT " bytes", max_length);
+		return FAILURE;
+	}
+	if (state != JOB_DONE) {
+		zephir_throw_exception_string(pocketmine_utils_binarydataexception_ce, SL("Failed to process data"));
+		return FAILURE;
+	}
+	binarystream_init_owned(return_value, out, ZSTR_LEN(out));
+	return SUCCESS;
+}
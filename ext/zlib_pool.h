@@ -0,0 +1,15 @@
+#ifndef ZLIB_POOL_H
+#define ZLIB_POOL_H
+
+#include <php.h>
+
+void zlib_pool_request_shutdown(void);
+
+int zlib_pool_start(zval *return_value, zval *workers);
+int zlib_pool_submit_compress(zval *return_value, zval *input, zval *level, zval *encoding);
+int zlib_pool_submit_decompress(zval *return_value, zval *input, zval *max_length, zval *encoding);
+int zlib_pool_poll(zval *return_value, zval *handle);
+int zlib_pool_ready(zval *return_value);
+int zlib_pool_collect(zval *return_value, zval *handle);
+
+#endif
@@ -0,0 +1,118 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+use Zephir\Call;
+use Zephir\CompilationContext;
+use Zephir\CompiledExpression;
+use Zephir\Exception\CompilerException;
+use Zephir\Optimizers\OptimizerAbstract;
+
+/**
+ * Base for functions implemented by the hand-written sources in ext/.
+ *
+ * The native function receives the result zval followed by the parameters as
+ * zvals and returns SUCCESS or FAILURE; on FAILURE it has already thrown, so
+ * the calling method unwinds like after any other failed call.
+ */
+abstract class AbstractNativeCallOptimizer extends OptimizerAbstract
+{
+    /**
+     * Name of the C function to call
+     *
+     * @var string
+     */
+    protected $nativeName;
+
+    /**
+     * Header declaring the C function, relative to ext/ and without ".h"
+     *
+     * @var string
+     */
+    protected $header;
+
+    /**
+     * Accepted number of parameters as [min, max]
+     *
+     * @var int[]
+     */
+    protected $parameterCount = [1, 1];
+
+    /**
+     * Position of a parameter that must be a string literal naming a C
+     * constant, e.g. "short" for BINARY_SHORT; it is passed as a plain int
+     *
+     * @var int|null
+     */
+    protected $constantParameter;
+
+    /**
+     * Prefix of the C constants named by the constant parameter
+     *
+     * @var string
+     */
+    protected $constantPrefix = 'BINARY_';
+
+    public function optimize(array $expression, Call $call, CompilationContext $context)
+    {
+        $count = isset($expression['parameters']) ? \count($expression['parameters']) : 0;
+        list($min, $max) = $this->parameterCount;
+        if ($count < $min || $count > $max) {
+            throw new CompilerException(
+                sprintf("'%s' requires %s parameters", $expression['name'], $min === $max ? $min : $min . ' to ' . $max),
+                $expression
+            );
+        }
+
+        /**
+         * Process the expected symbol to be returned
+         */
+        $call->processExpectedReturn($context);
+
+        $symbolVariable = $call->getSymbolVariable(true, $context);
+        if (!$symbolVariable->isVariable()) {
+            throw new CompilerException('Returned values by functions can only be assigned to variant variables', $expression);
+        }
+
+        $context->headersManager->add($this->header);
+        $context->symbolTable->mustGrownStack(true);
+
+        $parameters = $count > 0 ? $expression['parameters'] : [];
+        $constant = null;
+        if ($this->constantParameter !== null && $this->constantParameter < $count) {
+            $constant = $this->resolveConstant($parameters[$this->constantParameter], $expression);
+            array_splice($parameters, $this->constantParameter, 1);
+        }
+
+        $resolvedParams = \count($parameters) > 0 ? $call->getReadOnlyResolvedParams($parameters, $context, $expression) : [];
+        if ($constant !== null) {
+            array_splice($resolvedParams, $this->constantParameter, 0, [$constant]);
+        }
+
+        if ($call->mustInitSymbolVariable()) {
+            $symbolVariable->initVariant($context);
+        }
+
+        $call->addCallStatusFlag($context);
+
+        $symbol = $context->backend->getVariableCode($symbolVariable);
+        array_unshift($resolvedParams, $symbol);
+        $context->codePrinter->output('ZEPHIR_LAST_CALL_STATUS = ' . $this->nativeName . '(' . implode(', ', $resolvedParams) . ');');
+        $call->addCallStatusOrJump($context);
+
+        return new CompiledExpression('variable', $symbolVariable->getRealName(), $expression);
+    }
+
+    private function resolveConstant(array $parameter, array $expression)
+    {
+        $value = $parameter['parameter'];
+        if ($value['type'] !== 'string' || !preg_match('/^[a-z][a-z0-9_]*$/', $value['value'])) {
+            throw new CompilerException(
+                sprintf("'%s' expects a lowercase identifier string as parameter %d", $expression['name'], $this->constantParameter + 1),
+                $expression
+            );
+        }
+
+        return $this->constantPrefix . strtoupper($value['value']);
+    }
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class AckcodecNativeDecodeOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'ackcodec_native_decode';
+    protected $header = 'ackcodec_native';
+    protected $parameterCount = [3, 3];
+}
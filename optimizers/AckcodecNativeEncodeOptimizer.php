@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class AckcodecNativeEncodeOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'ackcodec_native_encode';
+    protected $header = 'ackcodec_native';
+    protected $parameterCount = [2, 2];
+}
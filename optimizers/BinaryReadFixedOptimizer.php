@@ -0,0 +1,13 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinaryReadFixedOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binary_read_fixed';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+    protected $constantParameter = 1;
+}
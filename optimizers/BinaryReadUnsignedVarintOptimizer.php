@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinaryReadUnsignedVarintOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binary_read_unsigned_varint';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
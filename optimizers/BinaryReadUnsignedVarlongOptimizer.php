@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinaryReadUnsignedVarlongOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binary_read_unsigned_varlong';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamAppendOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_append';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,13 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamGetFixedOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_get_fixed';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+    protected $constantParameter = 1;
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamGetRemainingOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_get_remaining';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [1, 1];
+}
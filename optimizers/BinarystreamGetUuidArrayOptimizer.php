@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamGetUuidArrayOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_get_uuid_array';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [3, 3];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamJoinLengthPrefixedOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_join_length_prefixed';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamPutBlockPositionOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_put_block_position';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [3, 3];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamPutByteOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_put_byte';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,13 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamPutFixedArrayOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_put_fixed_array';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [3, 3];
+    protected $constantParameter = 2;
+}
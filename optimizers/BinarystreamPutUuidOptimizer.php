@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamPutUuidOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_put_uuid';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamPutVector3Optimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_put_vector3';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
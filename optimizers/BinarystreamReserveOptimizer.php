@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamReserveOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_reserve';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [2, 2];
+}
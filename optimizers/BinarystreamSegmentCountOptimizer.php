@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreamSegmentCountOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystream_segment_count';
+    protected $header = 'binarystream_native';
+    protected $parameterCount = [1, 1];
+}
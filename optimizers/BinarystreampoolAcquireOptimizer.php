@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreampoolAcquireOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystreampool_acquire';
+    protected $header = 'binarystreampool_native';
+    protected $parameterCount = [1, 1];
+}
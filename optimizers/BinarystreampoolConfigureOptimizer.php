@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreampoolConfigureOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystreampool_configure';
+    protected $header = 'binarystreampool_native';
+    protected $parameterCount = [4, 4];
+}
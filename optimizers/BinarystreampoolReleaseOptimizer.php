@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreampoolReleaseOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystreampool_release';
+    protected $header = 'binarystreampool_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class BinarystreampoolTrimOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'binarystreampool_trim';
+    protected $header = 'binarystreampool_native';
+    protected $parameterCount = [2, 2];
+}
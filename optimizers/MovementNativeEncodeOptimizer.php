@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class MovementNativeEncodeOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'movement_native_encode';
+    protected $header = 'movement_native';
+    protected $parameterCount = [4, 4];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class NbtNativeReadOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'nbt_native_read';
+    protected $header = 'nbt_native';
+    protected $parameterCount = [4, 4];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class NbtNativeWriteOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'nbt_native_write';
+    protected $header = 'nbt_native';
+    protected $parameterCount = [3, 3];
+}
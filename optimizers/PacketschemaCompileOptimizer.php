@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PacketschemaCompileOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packetschema_compile';
+    protected $header = 'packetschema_native';
+    protected $parameterCount = [2, 2];
+}
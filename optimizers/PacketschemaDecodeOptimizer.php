@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PacketschemaDecodeOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packetschema_decode';
+    protected $header = 'packetschema_native';
+    protected $parameterCount = [3, 3];
+}
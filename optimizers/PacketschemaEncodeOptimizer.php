@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PacketschemaEncodeOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packetschema_encode';
+    protected $header = 'packetschema_native';
+    protected $parameterCount = [3, 3];
+}
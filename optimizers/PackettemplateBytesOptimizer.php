@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PackettemplateBytesOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packettemplate_bytes';
+    protected $header = 'packettemplate_native';
+    protected $parameterCount = [1, 1];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PackettemplateCompileOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packettemplate_compile';
+    protected $header = 'packettemplate_native';
+    protected $parameterCount = [4, 4];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PackettemplateInstantiateAllOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packettemplate_instantiate_all';
+    protected $header = 'packettemplate_native';
+    protected $parameterCount = [3, 3];
+}
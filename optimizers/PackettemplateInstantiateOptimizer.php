@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PackettemplateInstantiateOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packettemplate_instantiate';
+    protected $header = 'packettemplate_native';
+    protected $parameterCount = [2, 2];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class PackettemplateWriteOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'packettemplate_write';
+    protected $header = 'packettemplate_native';
+    protected $parameterCount = [3, 3];
+}
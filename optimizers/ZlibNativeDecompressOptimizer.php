@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class ZlibNativeDecompressOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'zlib_native_decompress';
+    protected $header = 'zlib_native';
+    protected $parameterCount = [3, 3];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class ZlibPoolPollOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'zlib_pool_poll';
+    protected $header = 'zlib_pool';
+    protected $parameterCount = [1, 1];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class ZlibPoolReadyOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'zlib_pool_ready';
+    protected $header = 'zlib_pool';
+    protected $parameterCount = [0, 0];
+}
@@ -0,0 +1,12 @@
+<?php
+
+namespace Zephir\Optimizers\FunctionCall;
+
+require_once __DIR__ . '/AbstractNativeCallOptimizer.php';
+
+class ZlibPoolSubmitDecompressOptimizer extends AbstractNativeCallOptimizer
+{
+    protected $nativeName = 'zlib_pool_submit_decompress';
+    protected $header = 'zlib_pool';
+    protected $parameterCount = [3, 3];
+}
@@ -0,0 +1,60 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Payload of RakNet ACK and NACK packets: a big-endian short record count
+ * followed by records of a single sequence number or a range of consecutive
+ * ones, as little-endian triads.
+ */
+class AckCodec
+{
+    const RECORD_TYPE_RANGE = 0;
+    const RECORD_TYPE_SINGLE = 1;
+
+    /**
+     * Writes the sequence numbers, in any order, compressed into ranges.
+     * Duplicates are written once.
+     *
+     * @param BinaryStream $stream
+     * @param int[]        $numbers 0 to 0xffffff
+     *
+     * @throws \InvalidArgumentException if a number is not a triad
+     */
+    public static function encode(<BinaryStream> stream, array numbers) -> void
+    {
+        ackcodec_native_encode(stream, numbers);
+    }
+
+    /**
+     * Reads the sequence numbers of a payload, in the order of its records.
+     * Ranges longer than maxRange are cut short and reading stops after
+     * maxCount numbers, so a forged payload cannot expand to millions of them.
+     *
+     * @param BinaryStream $stream
+     * @param int          $maxRange
+     * @param int          $maxCount
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if a record is truncated
+     */
+    public static function decode(<BinaryStream> stream, int maxRange = 512, int maxCount = 4096) -> array
+    {
+        return ackcodec_native_decode(stream, maxRange, maxCount);
+    }
+}
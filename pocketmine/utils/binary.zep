@@ -143,7 +143,7 @@ class Binary
      */
     public static function readShort(string str) -> int
     {
-        return unpack("n", str)[1];
+        return binary_read_fixed(str, "short");
     }
 
     /**
@@ -155,7 +155,7 @@ class Binary
      */
     public static function readSignedShort(string str) -> int
     {
-        return self::signShort(unpack("n", str)[1]);
+        return binary_read_fixed(str, "signed_short");
     }
 
     /**
@@ -167,7 +167,7 @@ class Binary
      */
     public static function writeShort(int value) -> string
     {
-        return pack("n", value);
+        return binary_write_fixed(value, "short");
     }
 
     /**
@@ -179,7 +179,7 @@ class Binary
      */
     public static function readLShort(string str) -> int
     {
-        return unpack("v", str)[1];
+        return binary_read_fixed(str, "lshort");
     }
 
     /**
@@ -191,7 +191,7 @@ class Binary
      */
     public static function readSignedLShort(string str) -> int
     {
-        return self::signShort(unpack("v", str)[1]);
+        return binary_read_fixed(str, "signed_lshort");
     }
 
     /**
@@ -203,7 +203,7 @@ class Binary
      */
     public static function writeLShort(int value) -> string
     {
-        return pack("v", value);
+        return binary_write_fixed(value, "lshort");
     }
 
     /**
@@ -213,9 +213,9 @@ class Binary
      *
      * @return int
      */
-    public static function readTriad(string str) -> string
+    public static function readTriad(string str) -> int
     {
-        return unpack("N", chr('\0') . str)[1];
+        return binary_read_fixed(str, "triad");
     }
 
     /**
@@ -225,9 +225,9 @@ class Binary
      *
      * @return string
      */
-    public static function writeTriad(int value) -> long
+    public static function writeTriad(int value) -> string
     {
-        return substr(pack("N", value), 1);
+        return binary_write_fixed(value, "triad");
     }
 
     /**
@@ -239,7 +239,7 @@ class Binary
      */
     public static function readLTriad(string str) -> long
     {
-        return unpack("V", str . chr('\0'))[1];
+        return binary_read_fixed(str, "ltriad");
     }
 
     /**
@@ -251,7 +251,7 @@ class Binary
      */
     public static function writeLTriad(long value) -> string
     {
-        return substr(pack("V", value), 0, -1);
+        return binary_write_fixed(value, "ltriad");
     }
 
     /**
@@ -263,7 +263,7 @@ class Binary
      */
     public static function readInt(string str) -> long
     {
-        return self::signInt(unpack("N", str)[1]);
+        return binary_read_fixed(str, "int");
     }
 
     /**
@@ -275,7 +275,7 @@ class Binary
      */
     public static function writeInt(long value) -> string
     {
-        return pack("N", value);
+        return binary_write_fixed(value, "int");
     }
 
     /**
@@ -287,7 +287,7 @@ class Binary
      */
     public static function readLInt(string str) -> long
     {
-        return self::signInt(unpack("V", str)[1]);
+        return binary_read_fixed(str, "lint");
     }
 
     /**
@@ -299,7 +299,7 @@ class Binary
      */
     public static function writeLInt(long value) -> string
     {
-        return pack("V", value);
+        return binary_write_fixed(value, "lint");
     }
 
     /**
@@ -311,7 +311,7 @@ class Binary
      */
     public static function readFloat(string str) -> float
     {
-        return unpack("G", str)[1];
+        return binary_read_fixed(str, "float");
     }
 
     /**
@@ -336,7 +336,7 @@ class Binary
      */
     public static function writeFloat(float value) -> string
     {
-        return pack("G", value);
+        return binary_write_fixed(value, "float");
     }
 
     /**
@@ -348,7 +348,7 @@ class Binary
      */
     public static function readLFloat(string str) -> float
     {
-        return unpack("g", str)[1];
+        return binary_read_fixed(str, "lfloat");
     }
 
     /**
@@ -373,7 +373,7 @@ class Binary
      */
     public static function writeLFloat(float value) -> string
     {
-        return pack("g", value);
+        return binary_write_fixed(value, "lfloat");
     }
 
     /**
@@ -397,7 +397,7 @@ class Binary
      */
     public static function readDouble(string str) -> float
     {
-        return unpack("E", str)[1];
+        return binary_read_fixed(str, "double");
     }
 
     /**
@@ -409,7 +409,7 @@ class Binary
      */
     public static function writeDouble(float value) -> string
     {
-        return pack("E", value);
+        return binary_write_fixed(value, "double");
     }
 
     /**
@@ -421,7 +421,7 @@ class Binary
      */
     public static function readLDouble(string str) -> float
     {
-        return unpack("e", str)[1];
+        return binary_read_fixed(str, "ldouble");
     }
 
     /**
@@ -433,7 +433,7 @@ class Binary
      */
     public static function writeLDouble(float value) -> string
     {
-        return pack("e", value);
+        return binary_write_fixed(value, "ldouble");
     }
 
     /**
@@ -445,7 +445,7 @@ class Binary
      */
     public static function readLong(string str) -> int
     {
-        return unpack("J", str)[1];
+        return binary_read_fixed(str, "long");
     }
 
     /**
@@ -457,7 +457,7 @@ class Binary
      */
     public static function writeLong(int value) -> string
     {
-        return pack("J", value);
+        return binary_write_fixed(value, "long");
     }
 
     /**
@@ -469,7 +469,7 @@ class Binary
      */
     public static function readLLong(string str) -> int
     {
-        return unpack("P", str)[1];
+        return binary_read_fixed(str, "llong");
     }
 
     /**
@@ -481,7 +481,7 @@ class Binary
      */
     public static function writeLLong(int value) -> string
     {
-        return pack("P", value);
+        return binary_write_fixed(value, "llong");
     }
 
     /**
@@ -494,9 +494,7 @@ class Binary
      */
     public static function readVarInt(string buffer, var& offset) -> int
     {
-        var raw = self::readUnsignedVarInt(buffer, offset);
-        uint temp = (((raw << 63) >> 63) ^ raw) >> 1;
-        return temp ^ raw & 1 << 63;
+        return binary_read_varint(buffer, offset);
     }
 
     /**
@@ -511,22 +509,7 @@ class Binary
      */
     public static function readUnsignedVarInt(string buffer, var& offset) -> uint
     {
-        int i = 0;
-        uint value = 0;
-        while i <= 28 {
-            if (!isset str_split(buffer)[offset]) {
-                throw new BinaryDataException("No bytes left in buffer");
-            }
-            var bVar = ord(buffer[(int) offset]);
-            int b = (int) bVar;
-            let offset++;
-            let value = value | ((b & 0x7f) << i);
-            if ((b & 0x80) === 0) {
-                return value;
-            }
-            let i += 7;
-        }
-        throw new BinaryDataException("VarInt did not terminate after 5 bytes!");
+        return binary_read_unsigned_varint(buffer, offset);
     }
 
     /**
@@ -538,8 +521,7 @@ class Binary
      */
     public static function writeVarInt(int v) -> string
     {
-        let v = ((v << 32) >> 32);
-        return self::writeUnsignedVarInt(v << 1 ^ v >> 31);
+        return binary_write_varint(v, "varint");
     }
 
     /**
@@ -551,20 +533,31 @@ class Binary
      */
     public static function writeUnsignedVarInt(uint value) -> string
     {
-        int i;
-        string buf = "";
-        uint value = value & 0xffffffff;
-        for i in range(0, 4) {
-            if ((value >> 7) !== 0) {
-                let buf .= chr(value | 0x80);
-            } else {
-                let buf .= chr(value & 0x7f);
-                return buf;
-            }
-            let value = value >> 7 & PHP_INT_MAX >> 6;
-            //PHP really needs a logical right-shift operator
-        }
-        throw new \InvalidArgumentException("Value too large to be encoded as a VarInt");
+        return binary_write_varint(value, "unsigned_varint");
+    }
+
+    /**
+     * Returns how many bytes writeVarInt() would produce for a value, without encoding it.
+     *
+     * @param int $v
+     *
+     * @return int 1 to 5
+     */
+    public static function varIntSize(int v) -> int
+    {
+        return binary_varint_size(v, "varint");
+    }
+
+    /**
+     * Returns how many bytes writeUnsignedVarInt() would produce for a value, without encoding it.
+     *
+     * @param int $value
+     *
+     * @return int 1 to 5
+     */
+    public static function unsignedVarIntSize(uint value) -> int
+    {
+        return binary_varint_size(value, "unsigned_varint");
     }
 
     /**
@@ -577,9 +570,7 @@ class Binary
      */
     public static function readVarLong(string buffer, var& offset) -> long
     {
-        var raw = self::readUnsignedVarLong(buffer, offset);
-        ulong temp = ((((long) raw << 63) >> 63) ^ raw) >> 1;
-        return temp ^ raw & 1 << 63;
+        return binary_read_varlong(buffer, offset);
     }
 
     /**
@@ -594,22 +585,7 @@ class Binary
      */
     public static function readUnsignedVarLong(string buffer, var& offset) -> ulong
     {
-        int i = 0;
-        ulong value = 0;
-        while i <= 63 {
-            if (!isset str_split(buffer)[(int) offset]) {
-                throw new BinaryDataException("No bytes left in buffer");
-            }
-            var bVar = ord(buffer[(int) offset]);
-            int b = (int) bVar;
-            let offset++;
-            let value = value | ((b & 0x7f) << i);
-            if ((b & 0x80) === 0) {
-                return value;
-            }
-	    let i += 7;
-        }
-        throw new BinaryDataException("VarLong did not terminate after 10 bytes!");
+        return binary_read_unsigned_varlong(buffer, offset);
     }
 
     /**
@@ -621,7 +597,7 @@ class Binary
      */
     public static function writeVarLong(long v) -> string
     {
-        return self::writeUnsignedVarLong(v << 1 ^ v >> 63);
+        return binary_write_varint(v, "varlong");
     }
 
     /**
@@ -633,20 +609,31 @@ class Binary
      */
     public static function writeUnsignedVarLong(ulong value) -> string
     {
-        int i;
-        string buf = "";
-        for i in range(0, 9)  {
-            if ((value >> 7) !== 0) {
-                let buf .= chr(value | 0x80);
-                //Let chr() take the last byte of this, it's faster than adding another & 0x7f.
-            } else {
-                let buf .= chr(value & 0x7f);
-                return buf;
-            }
-            let value = value >> 7 & PHP_INT_MAX >> 6;
-            //PHP really needs a logical right-shift operator
-        }
-        throw new \InvalidArgumentException("Value too large to be encoded as a VarLong");
+        return binary_write_varint(value, "unsigned_varlong");
+    }
+
+    /**
+     * Returns how many bytes writeVarLong() would produce for a value, without encoding it.
+     *
+     * @param int $v
+     *
+     * @return int 1 to 10
+     */
+    public static function varLongSize(long v) -> int
+    {
+        return binary_varint_size(v, "varlong");
+    }
+
+    /**
+     * Returns how many bytes writeUnsignedVarLong() would produce for a value, without encoding it.
+     *
+     * @param int $value
+     *
+     * @return int 1 to 10
+     */
+    public static function unsignedVarLongSize(ulong value) -> int
+    {
+        return binary_varint_size(value, "unsigned_varlong");
     }
 
 }
@@ -16,8 +16,26 @@
 
 namespace Pocketmine\Utils;
 
+use Pocketmine\Math\Vector3;
+
 class BinaryStream
 {
+    /* Error codes of getLastError() */
+    const ERROR_NONE = 0;
+    /* the buffer ended before the value did */
+    const ERROR_EOF = 1;
+    /* a var-int did not terminate within its maximum size */
+    const ERROR_OVERLONG = 2;
+
+    /* Access patterns of fromFile(), passed to the kernel as madvise() hints */
+    const ACCESS_NORMAL = 0;
+    /* read front to back, e.g. recorded packet dumps */
+    const ACCESS_SEQUENTIAL = 1;
+    /* read in scattered pieces, e.g. resource pack chunks */
+    const ACCESS_RANDOM = 2;
+    /* read soon in full, prefetched */
+    const ACCESS_WILLNEED = 3;
+
     /** @var long  */
     public offset {
         get
@@ -33,15 +51,47 @@ class BinaryStream
         let this->offset = offset;
     }
 
+    /**
+     * Opens a file as a read-only stream backed by a memory mapping instead of
+     * a string read into memory. Reads and slices come straight from the
+     * mapping, which stays alive while the stream or any of its slices does.
+     * Writing to the stream or reading its buffer copies the bytes into memory.
+     * The file must not be truncated while it is mapped.
+     *
+     * @param string $path
+     * @param int    $access one of the ACCESS_* constants
+     *
+     * @return BinaryStream
+     *
+     * @throws \RuntimeException if the file cannot be opened
+     */
+    public static function fromFile(string path, int access = 0) -> <BinaryStream>
+    {
+        return binarystream_from_file(path, access);
+    }
+
     public function setOffset(long offset) -> void
     {
         let this->offset = offset;
     }
 
+    /**
+     * Empties the stream. The allocated buffer capacity is kept for the next
+     * packet written into this stream.
+     */
     public function reset() -> void
     {
-        let this->buffer = "";
-        let this->offset = 0;
+        binarystream_reset(this);
+    }
+
+    /**
+     * Makes sure len more bytes can be written without growing the buffer again.
+     *
+     * @param int $len
+     */
+    public function reserve(long len) -> void
+    {
+        binarystream_reserve(this, len);
     }
 
     /**
@@ -67,23 +117,7 @@ class BinaryStream
      */
     public function get(long len) -> string
     {
-        if (len === 0) {
-            return "";
-        }
-        if (len < 0) {
-            throw new \InvalidArgumentException("Length must be positive");
-        }
-        var remaining;
-        let remaining = strlen(this->buffer) - this->offset;
-        if (remaining < len) {
-            throw new BinaryDataException("Not enough bytes left in buffer: need " . len  . ", have " . remaining);
-        }
-        if len === 1 {
-            let this->offset++;
-            return substr(this->buffer, this->offset - 1, 1);
-        }
-        let this->offset = len + (long) this->offset;
-        return substr(this->buffer, this->offset - len, len);
+        return binarystream_get(this, len);
     }
 
     /**
@@ -92,18 +126,98 @@ class BinaryStream
      */
     public function getRemaining() -> string
     {
-        var buflen = strlen(this->buffer);
-        if (this->offset >= buflen) {
-            throw new BinaryDataException("No bytes left to read");
-        }
-        var str = substr(this->buffer, this->offset);
-        let this->offset = buflen;
-        return str;
+        return binarystream_get_remaining(this);
+    }
+
+    /**
+     * Reads len bytes as a new stream positioned at its start. The bytes are
+     * shared with this stream and only copied once the slice is written to or
+     * its buffer is requested.
+     *
+     * @param int $len
+     *
+     * @return BinaryStream
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function slice(long len) -> <BinaryStream>
+    {
+        return binarystream_slice(this, len);
+    }
+
+    /**
+     * Reads the rest of the stream as a sequence of payloads each prefixed by
+     * its length as an unsigned var-int, like the packets of a batch. The
+     * payloads are returned as slices sharing this stream's buffer.
+     *
+     * @return BinaryStream[]
+     *
+     * @throws BinaryDataException if a length prefix is malformed or runs past the end of the buffer
+     */
+    public function splitLengthPrefixed() -> array
+    {
+        return binarystream_split_length_prefixed(this);
+    }
+
+    /**
+     * Writes each payload prefixed by its length as an unsigned var-int.
+     *
+     * @param string[]|BinaryStream[] $packets
+     */
+    public function joinLengthPrefixed(array packets) -> void
+    {
+        binarystream_join_length_prefixed(this, packets);
     }
 
+    /**
+     * Appends str. In segmented mode a string of at least the segment
+     * threshold is referenced instead of copied, see setSegmentThreshold().
+     *
+     * @param string $str
+     */
     public function put(string str) -> void
     {
-        let this->buffer = this->buffer . str;
+        binarystream_put(this, str);
+    }
+
+    /**
+     * Turns on segmented mode: put() of a string of at least threshold bytes
+     * keeps a reference to it as a segment instead of copying it into the
+     * buffer. The segments are flattened into one buffer only when the stream
+     * is read or its buffer is requested; writeTo() and zlib compression
+     * consume them as they are. 0 turns it off again.
+     *
+     * @param int $threshold
+     */
+    public function setSegmentThreshold(long threshold) -> void
+    {
+        binarystream_set_segment_threshold(this, threshold);
+    }
+
+    /**
+     * Returns how many strings are referenced by the stream and not yet flattened.
+     *
+     * @return int
+     */
+    public function getSegmentCount() -> int
+    {
+        return binarystream_segment_count(this);
+    }
+
+    /**
+     * Writes the whole buffer to a stream resource without flattening the
+     * segments, using writev() for pipes and stream sockets. The offset is
+     * not changed.
+     *
+     * @param resource $handle
+     *
+     * @return int bytes written, fewer than the length only when a non-blocking handle is full
+     *
+     * @throws \RuntimeException if the write fails
+     */
+    public function writeTo(var handle) -> int
+    {
+        return binarystream_write_to(this, handle);
     }
 
     public function getBool() -> bool
@@ -113,7 +227,7 @@ class BinaryStream
 
     public function putBool(bool v) -> void
     {
-        let this->buffer = this->buffer . (v ? '\1' : '\0');
+        binarystream_put_byte(this, v ? 1 : 0);
     }
 
     public function getByte() -> int
@@ -123,131 +237,333 @@ class BinaryStream
 
     public function putByte(int v) -> void
     {
-        let this->buffer = this->buffer . chr(v);
+        binarystream_put_byte(this, v);
     }
 
     public function getShort() -> int
     {
-        return unpack("n", this->get(2))[1];
+        return binarystream_get_fixed(this, "short");
     }
 
     public function getSignedShort() -> int
     {
-        var temp = unpack("n", this->get(2))[1];
-        return ((int) temp << 48) >> 48;
+        return binarystream_get_fixed(this, "signed_short");
     }
 
     public function putShort(int v) -> void
     {
-        let this->buffer = this->buffer . pack("n", v);
+        binarystream_put_fixed(this, v, "short");
     }
 
     public function getLShort() -> int
     {
-        return unpack("v", this->get(2))[1];
+        return binarystream_get_fixed(this, "lshort");
     }
 
     public function getSignedLShort() -> int
     {
-        var temp = unpack("v", this->get(2))[1];
-        return ((int) temp << 48) >> 48;
+        return binarystream_get_fixed(this, "signed_lshort");
     }
 
     public function putLShort(int v) -> void
     {
-        let this->buffer = this->buffer . pack("v", v);
+        binarystream_put_fixed(this, v, "lshort");
     }
 
     public function getTriad() -> long
     {
-        return unpack("N", chr('\0') . this->get(3))[1];
+        return binarystream_get_fixed(this, "triad");
     }
 
     public function putTriad(long v) -> void
     {
-        let this->buffer = this->buffer . substr(pack("N", v), 1);
+        binarystream_put_fixed(this, v, "triad");
     }
 
     public function getLTriad() -> long
     {
-        return unpack("V", this->get(3) . chr('\0'))[1];
+        return binarystream_get_fixed(this, "ltriad");
     }
 
     public function putLTriad(long v) -> void
     {
-        let this->buffer = this->buffer . substr(pack("V", v), 0, -1);
+        binarystream_put_fixed(this, v, "ltriad");
     }
 
     public function getInt() -> int
     {
-        var temp = unpack("N", this->get(4))[1];
-        return ((int) temp << 48) >> 48;
+        return binarystream_get_fixed(this, "int");
     }
 
     public function putInt(int v) -> void
     {
-        let this->buffer = this->buffer . pack("N", v);
+        binarystream_put_fixed(this, v, "int");
     }
 
     public function getLInt() -> long
     {
-        var temp = unpack("V", this->get(4))[1];
-        return ((long) temp << 48) >> 48;
+        return binarystream_get_fixed(this, "lint");
     }
 
     public function putLInt(long v) -> void
     {
-        let this->buffer = this->buffer . pack("V", v);
+        binarystream_put_fixed(this, v, "lint");
     }
 
     public function getFloat() -> float
     {
-        return unpack("G", this->get(4))[1];
+        return binarystream_get_fixed(this, "float");
     }
 
     public function getRoundedFloat(int accuracy) -> float
     {
-        return round(unpack("G", this->get(4))[1], accuracy);
+        return round(binarystream_get_fixed(this, "float"), accuracy);
     }
 
     public function putFloat(float v) -> void
     {
-        let this->buffer = this->buffer . pack("G", v);
+        binarystream_put_fixed(this, v, "float");
     }
 
     public function getLFloat() -> float
     {
-        return unpack("g", this->get(4))[1];
+        return binarystream_get_fixed(this, "lfloat");
     }
 
     public function getRoundedLFloat(int accuracy) -> float
     {
-        return round(unpack("g", this->get(4))[1], accuracy);
+        return round(binarystream_get_fixed(this, "lfloat"), accuracy);
     }
 
     public function putLFloat(float v) -> void
     {
-        let this->buffer = this->buffer . pack("g", v);
+        binarystream_put_fixed(this, v, "lfloat");
     }
 
     public function getDouble() -> float
     {
-        return unpack("E", this->get(8))[1];
+        return binarystream_get_fixed(this, "double");
     }
 
     public function putDouble(float v) -> void
     {
-        let this->buffer = this->buffer . pack("E", v);
+        binarystream_put_fixed(this, v, "double");
     }
 
     public function getLDouble() -> float
     {
-        return unpack("e", this->get(8))[1];
+        return binarystream_get_fixed(this, "ldouble");
     }
 
     public function putLDouble(float v) -> void
     {
-        let this->buffer = this->buffer . pack("e", v);
+        binarystream_put_fixed(this, v, "ldouble");
+    }
+
+    /**
+     * Reads count unsigned little-endian 2-byte integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getLShortArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "lshort");
+    }
+
+    /**
+     * Reads count signed little-endian 2-byte integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getSignedLShortArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "signed_lshort");
+    }
+
+    /**
+     * Writes each value of the array as a little-endian 2-byte integer.
+     *
+     * @param int[] $values
+     */
+    public function putLShortArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "lshort");
+    }
+
+    /**
+     * Reads count signed big-endian 4-byte integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getIntArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "int");
+    }
+
+    /**
+     * Writes each value of the array as a big-endian 4-byte integer.
+     *
+     * @param int[] $values
+     */
+    public function putIntArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "int");
+    }
+
+    /**
+     * Reads count signed little-endian 4-byte integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getLIntArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "lint");
+    }
+
+    /**
+     * Writes each value of the array as a little-endian 4-byte integer.
+     *
+     * @param int[] $values
+     */
+    public function putLIntArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "lint");
+    }
+
+    /**
+     * Reads count little-endian 8-byte integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getLLongArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "llong");
+    }
+
+    /**
+     * Writes each value of the array as a little-endian 8-byte integer.
+     *
+     * @param int[] $values
+     */
+    public function putLLongArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "llong");
+    }
+
+    /**
+     * Reads count big-endian 4-byte floats into a list.
+     *
+     * @param int $count
+     *
+     * @return float[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getFloatArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "float");
+    }
+
+    /**
+     * Writes each value of the array as a big-endian 4-byte float.
+     *
+     * @param float[] $values
+     */
+    public function putFloatArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "float");
+    }
+
+    /**
+     * Reads count little-endian 4-byte floats into a list.
+     *
+     * @param int $count
+     *
+     * @return float[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getLFloatArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "lfloat");
+    }
+
+    /**
+     * Writes each value of the array as a little-endian 4-byte float.
+     *
+     * @param float[] $values
+     */
+    public function putLFloatArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "lfloat");
+    }
+
+    /**
+     * Reads count big-endian 8-byte floats into a list.
+     *
+     * @param int $count
+     *
+     * @return float[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getDoubleArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "double");
+    }
+
+    /**
+     * Writes each value of the array as a big-endian 8-byte float.
+     *
+     * @param float[] $values
+     */
+    public function putDoubleArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "double");
+    }
+
+    /**
+     * Reads count little-endian 8-byte floats into a list.
+     *
+     * @param int $count
+     *
+     * @return float[]
+     *
+     * @throws BinaryDataException if there are not enough bytes left in the buffer
+     */
+    public function getLDoubleArray(long count) -> array
+    {
+        return binarystream_get_fixed_array(this, count, "ldouble");
+    }
+
+    /**
+     * Writes each value of the array as a little-endian 8-byte float.
+     *
+     * @param float[] $values
+     */
+    public function putLDoubleArray(array values) -> void
+    {
+        binarystream_put_fixed_array(this, values, "ldouble");
     }
 
     /**
@@ -255,7 +571,7 @@ class BinaryStream
      */
     public function getLong() -> int
     {
-        return Binary::readLong(this->get(8));
+        return binarystream_get_fixed(this, "long");
     }
 
     /**
@@ -263,7 +579,7 @@ class BinaryStream
      */
     public function putLong(int v) -> void
     {
-        let this->buffer = this->buffer . pack("NN", v >> 32, v & 0xffffffff);
+        binarystream_put_fixed(this, v, "long");
     }
 
     /**
@@ -271,7 +587,7 @@ class BinaryStream
      */
     public function getLLong() -> int
     {
-        return Binary::readLLong(this->get(8));
+        return binarystream_get_fixed(this, "llong");
     }
 
     /**
@@ -279,7 +595,7 @@ class BinaryStream
      */
     public function putLLong(int v) -> void
     {
-        let this->buffer = this->buffer . pack("VV", v & 0xffffffff, v >> 32);
+        binarystream_put_fixed(this, v, "llong");
     }
 
     /**
@@ -288,11 +604,7 @@ class BinaryStream
      */
     public function getUnsignedVarInt() -> int
     {
-        var funcValToRef = eval("return function &($v) { return $v; };");
-        var temp = {funcValToRef}(this->offset);
-        var result = Binary::readUnsignedVarInt(this->buffer, temp);
-        let this->offset = temp;
-        return (int) result;
+        return binarystream_get_unsigned_varint(this);
     }
 
     /**
@@ -301,7 +613,7 @@ class BinaryStream
      */
     public function putUnsignedVarInt(int v) -> void
     {
-        let this->buffer = this->buffer . Binary::writeUnsignedVarInt(v);
+        binarystream_put_varint(this, v, "unsigned_varint");
     }
 
     /**
@@ -310,11 +622,7 @@ class BinaryStream
      */
     public function getVarInt() -> int
     {
-        var funcValToRef = eval("return function &($v) { return $v; };");
-        var temp = {funcValToRef}(this->offset);
-        var result = Binary::readVarInt(this->buffer, temp);
-        let this->offset = temp;
-        return (int) result;
+        return binarystream_get_varint(this);
     }
 
     /**
@@ -323,7 +631,7 @@ class BinaryStream
      */
     public function putVarInt(int v) -> void
     {
-        let this->buffer = this->buffer . Binary::writeVarInt(v);
+        binarystream_put_varint(this, v, "varint");
     }
 
     /**
@@ -332,11 +640,7 @@ class BinaryStream
      */
     public function getUnsignedVarLong() -> long
     {
-        var funcValToRef = eval("return function &($v) { return $v; };");
-        var temp = {funcValToRef}(this->offset);
-        var result = Binary::readUnsignedVarLong(this->buffer, temp);
-        let this->offset = temp;
-        return (long) result;
+        return binarystream_get_unsigned_varlong(this);
     }
 
     /**
@@ -345,7 +649,7 @@ class BinaryStream
      */
     public function putUnsignedVarLong(long v) -> void
     {
-        let this->buffer = this->buffer . Binary::writeUnsignedVarLong(v);
+        binarystream_put_varint(this, v, "unsigned_varlong");
     }
 
     /**
@@ -354,11 +658,7 @@ class BinaryStream
      */
     public function getVarLong() -> long
     {
-        var funcValToRef = eval("return function &($v) { return $v; };");
-        var temp = {funcValToRef}(this->offset);
-        var result = Binary::readVarLong(this->buffer, temp);
-        let this->offset = temp;
-        return (long) result;
+        return binarystream_get_varlong(this);
     }
 
     /**
@@ -367,16 +667,663 @@ class BinaryStream
      */
     public function putVarLong(long v) -> void
     {
-        let this->buffer = this->buffer . Binary::writeVarLong(v);
+        binarystream_put_varint(this, v, "varlong");
     }
 
     /**
-     * Returns whether the offset has reached the end of the buffer.
-     * @return bool
+     * Reads a string prefixed by its length as an unsigned var-int.
+     *
+     * @param int $maxLength longest accepted string, -1 for no limit other than the bytes left
+     *
+     * @return string
+     *
+     * @throws BinaryDataException if the length exceeds maxLength or the bytes left; nothing is consumed then
      */
-    public function feof() -> bool
+    public function getString(long maxLength = -1) -> string
+    {
+        return binarystream_get_string(this, maxLength);
+    }
+
+    /**
+     * Like getString(), returning the bytes as a slice sharing this stream's
+     * buffer instead of copying them.
+     *
+     * @param int $maxLength longest accepted string, -1 for no limit other than the bytes left
+     *
+     * @return BinaryStream
+     *
+     * @throws BinaryDataException if the length exceeds maxLength or the bytes left; nothing is consumed then
+     */
+    public function getStringSlice(long maxLength = -1) -> <BinaryStream>
+    {
+        return binarystream_get_string_slice(this, maxLength);
+    }
+
+    /**
+     * Writes a string prefixed by its length as an unsigned var-int.
+     *
+     * @param string $v
+     */
+    public function putString(string v) -> void
+    {
+        binarystream_put_string(this, v);
+    }
+
+    /**
+     * Reads a UUID sent as two little-endian longs.
+     *
+     * @param bool $asString whether to return the dashed hex form instead of the 16 raw bytes
+     *
+     * @return string
+     */
+    public function getUUID(bool asString = false) -> string
+    {
+        return binarystream_get_uuid(this, asString);
+    }
+
+    /**
+     * Writes a UUID given as 16 raw bytes or 32 hex digits, optionally dashed.
+     *
+     * @param string $uuid
+     */
+    public function putUUID(string uuid) -> void
+    {
+        binarystream_put_uuid(this, uuid);
+    }
+
+    /**
+     * Reads count UUIDs like getUUID() into a list.
+     *
+     * @param int  $count
+     * @param bool $asString
+     *
+     * @return string[]
+     */
+    public function getUUIDArray(long count, bool asString = false) -> array
+    {
+        return binarystream_get_uuid_array(this, count, asString);
+    }
+
+    /**
+     * Writes each UUID like putUUID(); nothing is written if one is invalid.
+     *
+     * @param string[] $uuids
+     */
+    public function putUUIDArray(array uuids) -> void
+    {
+        binarystream_put_uuid_array(this, uuids);
+    }
+
+    /**
+     * Reads a block position as var-int x, unsigned var-int y and var-int z.
+     *
+     * @return Vector3 with integer components
+     */
+    public function getBlockPosition() -> <Vector3>
+    {
+        return binarystream_get_block_position(this, false);
+    }
+
+    /**
+     * Reads a block position whose y is a var-int too.
+     *
+     * @return Vector3 with integer components
+     */
+    public function getSignedBlockPosition() -> <Vector3>
+    {
+        return binarystream_get_block_position(this, true);
+    }
+
+    /**
+     * Writes a block position as var-int x, unsigned var-int y and var-int z;
+     * float components are rounded down.
+     *
+     * @param Vector3 $pos
+     */
+    public function putBlockPosition(<Vector3> pos) -> void
+    {
+        binarystream_put_block_position(this, pos, false);
+    }
+
+    /**
+     * Writes a block position whose y is a var-int too.
+     *
+     * @param Vector3 $pos
+     */
+    public function putSignedBlockPosition(<Vector3> pos) -> void
+    {
+        binarystream_put_block_position(this, pos, true);
+    }
+
+    /**
+     * Reads three little-endian floats as a Vector3.
+     *
+     * @return Vector3
+     */
+    public function getVector3() -> <Vector3>
+    {
+        return binarystream_get_vector3(this);
+    }
+
+    /**
+     * Writes the components of a Vector3 as three little-endian floats.
+     *
+     * @param Vector3 $vector
+     */
+    public function putVector3(<Vector3> vector) -> void
+    {
+        binarystream_put_vector3(this, vector);
+    }
+
+    /**
+     * Reads count vectors like getVector3() into a list.
+     *
+     * @param int $count
+     *
+     * @return Vector3[]
+     */
+    public function getVector3Array(long count) -> array
+    {
+        return binarystream_get_vector3_array(this, count);
+    }
+
+    /**
+     * Writes each vector like putVector3(); nothing is written if one is not a Vector3.
+     *
+     * @param Vector3[] $vectors
+     */
+    public function putVector3Array(array vectors) -> void
+    {
+        binarystream_put_vector3_array(this, vectors);
+    }
+
+    /**
+     * Reads count 32-bit variable-length unsigned integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if a var-int did not end after 5 bytes or there were not enough bytes
+     */
+    public function getUnsignedVarIntArray(long count) -> array
+    {
+        return binarystream_get_unsigned_varint_array(this, count);
+    }
+
+    /**
+     * Writes each value of the array as a 32-bit variable-length unsigned integer.
+     *
+     * @param int[] $values
+     */
+    public function putUnsignedVarIntArray(array values) -> void
+    {
+        binarystream_put_unsigned_varint_array(this, values);
+    }
+
+    /**
+     * Reads count 32-bit zigzag-encoded variable-length integers into a list.
+     *
+     * @param int $count
+     *
+     * @return int[]
+     *
+     * @throws BinaryDataException if a var-int did not end after 5 bytes or there were not enough bytes
+     */
+    public function getVarIntArray(long count) -> array
+    {
+        return binarystream_get_varint_array(this, count);
+    }
+
+    /**
+     * Writes each value of the array as a 32-bit zigzag-encoded variable-length integer.
+     *
+     * @param int[] $values
+     */
+    public function putVarIntArray(array values) -> void
+    {
+        binarystream_put_varint_array(this, values);
+    }
+
+    /**
+     * Returns whether the offset has reached the end of the buffer.
+     * @return bool
+     */
+    public function feof() -> bool
+    {
+        return binarystream_feof(this);
+    }
+
+    /**
+     * Adds bytes received so far to the end of the buffer, for reading them
+     * with the pull*() methods. Once at least half of the buffer has been read
+     * the read bytes are dropped first, and the offset moves back by as many.
+     *
+     * @param string|BinaryStream $bytes
+     */
+    public function append(var bytes) -> void
+    {
+        binarystream_append(this, bytes);
+    }
+
+    /**
+     * Like get(), but returns null and consumes nothing when fewer than len
+     * bytes have been received yet.
+     *
+     * @param int $len
+     *
+     * @return string|null
+     */
+    public function pull(long len) -> string|null
+    {
+        return binarystream_pull(this, len);
+    }
+
+    /**
+     * Like slice(), but returns null and consumes nothing when fewer than len
+     * bytes have been received yet.
+     *
+     * @param int $len
+     *
+     * @return BinaryStream|null
+     */
+    public function pullSlice(long len) -> <BinaryStream>|null
+    {
+        return binarystream_pull_slice(this, len);
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullByte() -> int|null
+    {
+        var b;
+
+        let b = binarystream_pull(this, 1);
+        if b === null {
+            return null;
+        }
+        return ord(b);
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullShort() -> int|null
+    {
+        return binarystream_pull_fixed(this, "short");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullSignedShort() -> int|null
+    {
+        return binarystream_pull_fixed(this, "signed_short");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullLShort() -> int|null
+    {
+        return binarystream_pull_fixed(this, "lshort");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullSignedLShort() -> int|null
+    {
+        return binarystream_pull_fixed(this, "signed_lshort");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullTriad() -> long|null
+    {
+        return binarystream_pull_fixed(this, "triad");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullLTriad() -> long|null
+    {
+        return binarystream_pull_fixed(this, "ltriad");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullInt() -> int|null
+    {
+        return binarystream_pull_fixed(this, "int");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullLInt() -> long|null
+    {
+        return binarystream_pull_fixed(this, "lint");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullLong() -> int|null
+    {
+        return binarystream_pull_fixed(this, "long");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function pullLLong() -> int|null
+    {
+        return binarystream_pull_fixed(this, "llong");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function pullFloat() -> float|null
+    {
+        return binarystream_pull_fixed(this, "float");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function pullLFloat() -> float|null
+    {
+        return binarystream_pull_fixed(this, "lfloat");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function pullDouble() -> float|null
+    {
+        return binarystream_pull_fixed(this, "double");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function pullLDouble() -> float|null
+    {
+        return binarystream_pull_fixed(this, "ldouble");
+    }
+
+    /**
+     * Reads a 32-bit variable-length unsigned integer, or returns null when
+     * the buffer ends inside it. The bytes read so far are kept, so the next call
+     * at the same offset continues behind them.
+     *
+     * @return int|null
+     *
+     * @throws BinaryDataException if the value did not terminate within its maximum size
+     */
+    public function pullUnsignedVarInt() -> int|null
+    {
+        return binarystream_pull_varint(this, "unsigned_varint");
+    }
+
+    /**
+     * Reads a 32-bit zigzag-encoded variable-length integer like pullUnsignedVarInt().
+     *
+     * @return int|null
+     */
+    public function pullVarInt() -> int|null
+    {
+        return binarystream_pull_varint(this, "varint");
+    }
+
+    /**
+     * Reads a 64-bit variable-length integer like pullUnsignedVarInt().
+     *
+     * @return int|null
+     */
+    public function pullUnsignedVarLong() -> long|null
+    {
+        return binarystream_pull_varint(this, "unsigned_varlong");
+    }
+
+    /**
+     * Reads a 64-bit zigzag-encoded variable-length integer like pullUnsignedVarInt().
+     *
+     * @return int|null
+     */
+    public function pullVarLong() -> long|null
+    {
+        return binarystream_pull_varint(this, "varlong");
+    }
+
+    /**
+     * Like get(), but returns null instead of throwing when there are not
+     * enough bytes left. The failure is recorded for getLastError() and
+     * getErrorOffset(); this holds for all the tryGet*() methods.
+     *
+     * @param int $len
+     *
+     * @return string|null
+     */
+    public function tryGet(long len) -> string|null
+    {
+        return binarystream_try_get(this, len);
+    }
+
+    /**
+     * Like slice(), but returns null instead of throwing.
+     *
+     * @param int $len
+     *
+     * @return BinaryStream|null
+     */
+    public function trySlice(long len) -> <BinaryStream>|null
+    {
+        return binarystream_try_slice(this, len);
+    }
+
+    /**
+     * @return bool|null
+     */
+    public function tryGetBool() -> bool|null
+    {
+        var b;
+
+        let b = binarystream_try_get(this, 1);
+        if b === null {
+            return null;
+        }
+        return b !== '\0';
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetByte() -> int|null
+    {
+        var b;
+
+        let b = binarystream_try_get(this, 1);
+        if b === null {
+            return null;
+        }
+        return ord(b);
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetShort() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "short");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetSignedShort() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "signed_short");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetLShort() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "lshort");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetSignedLShort() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "signed_lshort");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetTriad() -> long|null
+    {
+        return binarystream_try_get_fixed(this, "triad");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetLTriad() -> long|null
+    {
+        return binarystream_try_get_fixed(this, "ltriad");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetInt() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "int");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetLInt() -> long|null
+    {
+        return binarystream_try_get_fixed(this, "lint");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetLong() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "long");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetLLong() -> int|null
+    {
+        return binarystream_try_get_fixed(this, "llong");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function tryGetFloat() -> float|null
+    {
+        return binarystream_try_get_fixed(this, "float");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function tryGetLFloat() -> float|null
+    {
+        return binarystream_try_get_fixed(this, "lfloat");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function tryGetDouble() -> float|null
+    {
+        return binarystream_try_get_fixed(this, "double");
+    }
+
+    /**
+     * @return float|null
+     */
+    public function tryGetLDouble() -> float|null
+    {
+        return binarystream_try_get_fixed(this, "ldouble");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetUnsignedVarInt() -> int|null
+    {
+        return binarystream_try_get_varint(this, "unsigned_varint");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetVarInt() -> int|null
+    {
+        return binarystream_try_get_varint(this, "varint");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetUnsignedVarLong() -> long|null
+    {
+        return binarystream_try_get_varint(this, "unsigned_varlong");
+    }
+
+    /**
+     * @return int|null
+     */
+    public function tryGetVarLong() -> long|null
+    {
+        return binarystream_try_get_varint(this, "varlong");
+    }
+
+    /**
+     * Returns the first failure of a tryGet*() read since the stream was
+     * created, reset or cleared, as one of the ERROR_* constants.
+     *
+     * @return int
+     */
+    public function getLastError() -> int
+    {
+        return binarystream_last_error(this);
+    }
+
+    /**
+     * Returns the offset the failed read started at, or -1 without a failure.
+     *
+     * @return int
+     */
+    public function getErrorOffset() -> long
+    {
+        return binarystream_error_offset(this);
+    }
+
+    public function clearError() -> void
     {
-        return !isset str_split((string) this->buffer)[(int) this->offset];
+        binarystream_clear_error(this);
     }
 
 }
@@ -0,0 +1,88 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Recycles BinaryStreams together with their allocated buffers, so encoding
+ * packets in a steady state does not allocate. A released stream must not be
+ * used any more by the code that released it.
+ */
+class BinaryStreamPool
+{
+    /** @var int idle streams kept at most, more released streams are dropped */
+    protected maxStreams {
+        get
+    };
+    /** @var int released streams whose buffer grew beyond this many bytes give it up */
+    protected maxCapacity {
+        get
+    };
+
+    /**
+     * @param int $maxStreams
+     * @param int $maxCapacity
+     */
+    public function __construct(int maxStreams = 64, long maxCapacity = 1048576)
+    {
+        binarystreampool_configure(this, maxStreams, maxCapacity);
+        let this->maxStreams = maxStreams;
+        let this->maxCapacity = maxCapacity;
+    }
+
+    /**
+     * Returns an empty stream, reusing the most recently released one.
+     *
+     * @return BinaryStream
+     */
+    public function acquire() -> <BinaryStream>
+    {
+        return binarystreampool_acquire(this);
+    }
+
+    /**
+     * Empties the stream and keeps it for acquire().
+     *
+     * @param BinaryStream $stream
+     *
+     * @throws \InvalidArgumentException if the stream is already in the pool
+     */
+    public function release(<BinaryStream> stream) -> void
+    {
+        binarystreampool_release(this, stream);
+    }
+
+    /**
+     * Frees idle streams, the least recently released first, until keep are left.
+     *
+     * @param int $keep
+     */
+    public function trim(int keep = 0) -> void
+    {
+        binarystreampool_trim(this, keep);
+    }
+
+    /**
+     * Returns hits and misses of acquire(), the released streams discarded
+     * because the pool was full, the idle streams and the buffer bytes they hold.
+     *
+     * @return int[] with keys hits, misses, discarded, idle and bytesRetained
+     */
+    public function getStats() -> array
+    {
+        return binarystreampool_stats(this);
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Builds the MoveActorDeltaPacket of every entity that moved since the state
+ * last sent, in one pass. Entity states are lists of x, y, z, pitch, yaw and
+ * head yaw keyed by runtime entity ID. Rotations are sent as bytes of 256
+ * steps per turn.
+ */
+class MovementDelta
+{
+    const NETWORK_ID = 0x6f;
+
+    /* Fields present in a packet */
+    const FLAG_HAS_X = 0x01;
+    const FLAG_HAS_Y = 0x02;
+    const FLAG_HAS_Z = 0x04;
+    const FLAG_HAS_ROT_X = 0x08;
+    const FLAG_HAS_ROT_Y = 0x10;
+    const FLAG_HAS_ROT_Z = 0x20;
+
+    /**
+     * Appends one packet per entity of current whose position moved by more
+     * than threshold on an axis or whose quantized rotation changed, each
+     * prefixed by its length as an unsigned var-int like in a batch. Entities
+     * missing from previous are sent with every field.
+     *
+     * @param BinaryStream $stream
+     * @param array        $previous runtime entity ID => [x, y, z, pitch, yaw, headYaw] last sent
+     * @param array        $current  runtime entity ID => [x, y, z, pitch, yaw, headYaw] now
+     * @param float        $threshold
+     *
+     * @return int number of packets written
+     *
+     * @throws \InvalidArgumentException if a state is not a list of six numbers
+     */
+    public static function encode(<BinaryStream> stream, array previous, array current, double threshold = 0.01) -> int
+    {
+        return movement_native_encode(stream, previous, current, threshold);
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Reads and writes whole NBT trees in one call.
+ *
+ * Every tag is a [type, value] pair. A compound's value is an array of pairs
+ * keyed by tag name, a list's value is [element type, values] with bare
+ * values, byte arrays are strings and int and long arrays are int[]. A root
+ * tag is given as [name => [type, value]].
+ */
+class Nbt
+{
+    const TAG_END = 0;
+    const TAG_BYTE = 1;
+    const TAG_SHORT = 2;
+    const TAG_INT = 3;
+    const TAG_LONG = 4;
+    const TAG_FLOAT = 5;
+    const TAG_DOUBLE = 6;
+    const TAG_BYTE_ARRAY = 7;
+    const TAG_STRING = 8;
+    const TAG_LIST = 9;
+    const TAG_COMPOUND = 10;
+    const TAG_INT_ARRAY = 11;
+    const TAG_LONG_ARRAY = 12;
+
+    /* Little-endian with var-int ints, longs and lengths, as sent in packets */
+    const NETWORK = 0;
+    /* Little-endian fixed-width, as stored on disk */
+    const LITTLE_ENDIAN = 1;
+
+    /**
+     * Reads the root tag at the stream offset.
+     *
+     * @param BinaryStream $stream
+     * @param int          $flavour NETWORK or LITTLE_ENDIAN
+     * @param int          $maxDepth deepest nesting of lists and compounds accepted
+     * @param int          $maxTags most tags accepted, counting the root and every compound entry and list element
+     *
+     * @return array
+     *
+     * @throws BinaryDataException if the data is malformed, too deep, has too many tags or has lengths running past the end of the buffer
+     */
+    public static function read(<BinaryStream> stream, int flavour = 0 /* NETWORK */, int maxDepth = 512, int maxTags = 262144) -> array
+    {
+        return nbt_native_read(stream, flavour, maxDepth, maxTags);
+    }
+
+    /**
+     * Writes a root tag to the end of the stream, or nothing when part of it is invalid.
+     *
+     * @param BinaryStream $stream
+     * @param array        $root [name => [type, value]]
+     * @param int          $flavour NETWORK or LITTLE_ENDIAN
+     */
+    public static function write(<BinaryStream> stream, array root, int flavour = 0 /* NETWORK */) -> void
+    {
+        nbt_native_write(stream, root, flavour);
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Field layout of a packet, compiled once and then decoded from or encoded to
+ * a BinaryStream in a single call.
+ *
+ * Field types are named after the BinaryStream methods reading them: bool,
+ * byte, short, signed_short, lshort, signed_lshort, triad, ltriad, int, lint,
+ * long, llong, float, lfloat, double, ldouble, unsigned_varint, varint,
+ * unsigned_varlong, varlong, string (unsigned varint length prefix) and
+ * vector3 (three little-endian floats).
+ */
+class PacketSchema
+{
+    /** @var string[] field name => type, in wire order */
+    protected fields {
+        get
+    };
+
+    /**
+     * @param string[] $fields field name => type, in wire order
+     *
+     * @throws \InvalidArgumentException if a type is unknown
+     */
+    public function __construct(array fields)
+    {
+        packetschema_compile(this, fields);
+        let this->fields = fields;
+    }
+
+    /**
+     * Reads all fields from the stream. They are returned as an array keyed by
+     * field name, or assigned to the properties of target when it is given.
+     *
+     * @param BinaryStream $stream
+     * @param object|null  $target
+     *
+     * @return array|object
+     *
+     * @throws BinaryDataException
+     */
+    public function decode(<BinaryStream> stream, var target = null)
+    {
+        return packetschema_decode(this, stream, target);
+    }
+
+    /**
+     * Writes all fields to the stream, taking them from an array keyed by field
+     * name or from the properties of an object. Nothing is written when a
+     * field is missing or can't be encoded.
+     *
+     * @param BinaryStream $stream
+     * @param array|object $values
+     */
+    public function encode(<BinaryStream> stream, var values) -> void
+    {
+        packetschema_encode(this, stream, values);
+    }
+}
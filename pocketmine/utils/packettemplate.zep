@@ -0,0 +1,92 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * A packet encoded once by a PacketSchema, copied for each recipient with a
+ * few designated fields encoded again from per-recipient values. Fields that
+ * change size, such as var-ints and strings, are re-encoded at their new
+ * length; everything else is copied from the template as it is.
+ */
+class PacketTemplate
+{
+    /**
+     * @param PacketSchema $schema
+     * @param array|object $values    all fields, as taken by PacketSchema::encode()
+     * @param string[]     $patchable names of the fields that can be patched
+     *
+     * @throws \InvalidArgumentException if a field is missing or unknown
+     */
+    public function __construct(<PacketSchema> schema, var values, array patchable)
+    {
+        packettemplate_compile(this, schema, values, patchable);
+    }
+
+    /**
+     * Appends a copy of the packet to the stream, or nothing when a patched
+     * field can't be encoded.
+     *
+     * @param BinaryStream $stream
+     * @param array        $patches field name => value of the fields to change
+     *
+     * @throws \InvalidArgumentException if a field is not patchable
+     */
+    public function write(<BinaryStream> stream, array patches = []) -> void
+    {
+        packettemplate_write(this, stream, patches);
+    }
+
+    /**
+     * Returns a copy of the packet in a new stream.
+     *
+     * @param array $patches field name => value of the fields to change
+     *
+     * @return BinaryStream
+     *
+     * @throws \InvalidArgumentException if a field is not patchable
+     */
+    public function instantiate(array patches = []) -> <BinaryStream>
+    {
+        return packettemplate_instantiate(this, patches);
+    }
+
+    /**
+     * Returns one copy of the packet per value with the field set to it, under
+     * the same key, e.g. one per player for an array of runtime entity IDs.
+     *
+     * @param string $field
+     * @param array  $values
+     *
+     * @return BinaryStream[]
+     *
+     * @throws \InvalidArgumentException if the field is not patchable
+     */
+    public function instantiateAll(string field, array values) -> array
+    {
+        return packettemplate_instantiate_all(this, field, values);
+    }
+
+    /**
+     * Returns the packet as it was encoded.
+     *
+     * @return string
+     */
+    public function getBuffer() -> string
+    {
+        return packettemplate_bytes(this);
+    }
+}
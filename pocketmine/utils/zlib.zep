@@ -0,0 +1,58 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Batch compression with deflate contexts kept alive between calls
+ */
+class Zlib
+{
+    /* Same values as PHP's ZLIB_ENCODING_* constants */
+    const ENCODING_RAW = -15;
+    const ENCODING_DEFLATE = 15;
+    const ENCODING_GZIP = 31;
+
+    /**
+     * Compresses a string or the whole buffer of a BinaryStream.
+     *
+     * @param string|BinaryStream $input
+     * @param int                 $level -1 to 9
+     * @param int                 $encoding one of the ENCODING_* constants
+     *
+     * @return BinaryStream
+     */
+    public static function compress(var input, int level = 7, int encoding = -15 /* ENCODING_RAW */) -> <BinaryStream>
+    {
+        return zlib_native_compress(input, level, encoding);
+    }
+
+    /**
+     * Decompresses a string or the whole buffer of a BinaryStream.
+     *
+     * @param string|BinaryStream $input
+     * @param int                 $maxLength decompressed data longer than this is rejected
+     * @param int                 $encoding one of the ENCODING_* constants
+     *
+     * @return BinaryStream
+     *
+     * @throws BinaryDataException if the data is corrupt, truncated or longer than maxLength
+     */
+    public static function decompress(var input, long maxLength, int encoding = -15 /* ENCODING_RAW */) -> <BinaryStream>
+    {
+        return zlib_native_decompress(input, maxLength, encoding);
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * This file is part of RapidPM.
+ * 
+ * RapidPM is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * RapidPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with RapidPM.  If not, see <https://www.gnu.org/licenses/>.
+ *
+*/
+
+namespace Pocketmine\Utils;
+
+/**
+ * Compression on background threads. Jobs are submitted with the same
+ * arguments as Zlib::compress()/decompress() and return a handle that can be
+ * polled and must eventually be collected; jobs still pending when the
+ * request ends are discarded. Each thread has its own workers and handles.
+ */
+class ZlibPool
+{
+    /**
+     * Starts the worker threads; submitting a job starts 4 if this was not called.
+     *
+     * @param int $workers 1 to 64
+     */
+    public static function start(int workers) -> void
+    {
+        zlib_pool_start(workers);
+    }
+
+    /**
+     * @param string|BinaryStream $input
+     * @param int                 $level -1 to 9
+     * @param int                 $encoding one of the Zlib::ENCODING_* constants
+     *
+     * @return int handle
+     */
+    public static function submitCompress(var input, int level = 7, int encoding = -15 /* Zlib::ENCODING_RAW */) -> int
+    {
+        return zlib_pool_submit_compress(input, level, encoding);
+    }
+
+    /**
+     * @param string|BinaryStream $input
+     * @param int                 $maxLength decompressed data longer than this is rejected
+     * @param int                 $encoding one of the Zlib::ENCODING_* constants
+     *
+     * @return int handle
+     */
+    public static function submitDecompress(var input, long maxLength, int encoding = -15 /* Zlib::ENCODING_RAW */) -> int
+    {
+        return zlib_pool_submit_decompress(input, maxLength, encoding);
+    }
+
+    /**
+     * Returns whether the job has finished, without waiting.
+     */
+    public static function poll(int handle) -> bool
+    {
+        return zlib_pool_poll(handle);
+    }
+
+    /**
+     * Returns the handles of all finished jobs, oldest first.
+     *
+     * @return int[]
+     */
+    public static function ready() -> array
+    {
+        return zlib_pool_ready();
+    }
+
+    /**
+     * Waits for the job if it is still running and returns its output. The
+     * handle can't be used afterwards.
+     *
+     * @return BinaryStream
+     *
+     * @throws BinaryDataException if the data is corrupt, truncated or longer than maxLength
+     */
+    public static function collect(int handle) -> <BinaryStream>
+    {
+        return zlib_pool_collect(handle);
+    }
+}